@@ -0,0 +1,76 @@
+/*
+ *  Evoimage-gl, a library and program to evolve images
+ *  Copyright (C) 2009 Brent Burton
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+#include <cmath>
+#include <algorithm>
+#include "AcceptancePolicy.h"
+#include "Tools.h"
+
+namespace ei
+{
+    AcceptancePolicy::~AcceptancePolicy()
+    { }
+
+    bool AcceptancePolicy::monotone() const
+    { return false; }
+
+    bool GreedyAcceptance::accept(uint32_t current, uint32_t candidate, int, int)
+    { return candidate < current; }
+
+    bool GreedyAcceptance::monotone() const
+    { return true; }
+
+    ScheduledAcceptance::ScheduledAcceptance(double start, double end, CoolingSchedule schedule)
+        : m_start(start), m_end(end), m_schedule(schedule)
+    { }
+
+    double ScheduledAcceptance::level(int generation, int limit) const
+    {
+        double progress = std::min(1.0, std::max(0.0, double(generation) / std::max(limit, 1)));
+        if (m_schedule == CoolLinear || m_start <= 0 || m_end <= 0)
+            return m_start + (m_end - m_start) * progress;
+        return m_start * std::pow(m_end / m_start, progress);
+    }
+
+    AnnealingAcceptance::AnnealingAcceptance(double start, double end, CoolingSchedule schedule)
+        : ScheduledAcceptance(start, end, schedule)
+    { }
+
+    bool AnnealingAcceptance::accept(uint32_t current, uint32_t candidate,
+                                     int generation, int limit)
+    {
+        if (candidate < current)
+            return true;
+        double t = level(generation, limit) * current;
+        if (t <= 0)
+            return false;
+        double p = std::exp(-double(candidate - current) / t);
+        return Tools::getRandomNumber(0, 999999) < p * 1000000;
+    }
+
+    ThresholdAcceptance::ThresholdAcceptance(double start, double end, CoolingSchedule schedule)
+        : ScheduledAcceptance(start, end, schedule)
+    { }
+
+    bool ThresholdAcceptance::accept(uint32_t current, uint32_t candidate,
+                                     int generation, int limit)
+    {
+        return candidate < current ||
+               candidate - current <= level(generation, limit) * current;
+    }
+}
@@ -0,0 +1,106 @@
+/*
+ *  Evoimage-gl, a library and program to evolve images
+ *  Copyright (C) 2009 Brent Burton
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+#include <algorithm>
+#include <cmath>
+#include "AdaptiveRates.h"
+#include "DnaDrawing.h"
+#include "Settings.h"
+
+namespace ei
+{
+    AdaptiveRates::AdaptiveRates(double bound, unsigned minTrials, unsigned horizon)
+        : m_bound(std::max(bound, 1.0)), m_minTrials(minTrials),
+          m_horizon(std::max(horizon, minTrials))
+    {
+        for (int i = 0; i < MutationOpCount; i++)
+        {
+            m_base[i] = Settings::activeMutationRate(MutationOp(i));
+            m_rate[i] = m_base[i];
+            m_trials[i] = 0;
+            m_credit[i] = 0;
+        }
+    }
+
+    void AdaptiveRates::record(DnaDrawing &child, bool accepted)
+    {
+        for (int i = 0; i < MutationOpCount; i++)
+        {
+            unsigned count = child.opCount(MutationOp(i));
+            if (count)
+            {
+                m_trials[i] += count;
+                if (accepted)
+                    m_credit[i] += count;
+            }
+        }
+    }
+
+    void AdaptiveRates::update()
+    {
+        // Success rate per application, over the ops with enough samples
+        double score[MutationOpCount];
+        double sum = 0;
+        int    scoredOps = 0;
+        for (int i = 0; i < MutationOpCount; i++)
+        {
+            score[i] = -1;
+            if (scored(MutationOp(i)))
+            {
+                score[i] = m_credit[i] / m_trials[i];
+                sum += score[i];
+                scoredOps++;
+            }
+        }
+
+        if (scoredOps > 1 && sum > 0)
+        {
+            double mean = sum / scoredOps;
+            for (int i = 0; i < MutationOpCount; i++)
+            {
+                if (score[i] < 0)
+                    continue;
+
+                // Rates are "1 in n": a better than average op gets a
+                // smaller n. Steps are damped, since credit is noisy.
+                double factor = std::min(std::max(std::sqrt(score[i] / mean), 0.75), 1.33);
+                double lo = std::max(m_base[i] / m_bound, 1.0);
+                double hi = m_base[i] * m_bound;
+                m_rate[i] = std::min(std::max(m_rate[i] / factor, lo), hi);
+                Settings::activeMutationRate(MutationOp(i)) = int(std::lround(m_rate[i]));
+            }
+        }
+
+        // Forget evenly beyond the last m_horizon applications of each op
+        for (int i = 0; i < MutationOpCount; i++)
+        {
+            if (m_trials[i] > m_horizon)
+            {
+                double keep = m_horizon / m_trials[i];
+                m_trials[i] *= keep;
+                m_credit[i] *= keep;
+            }
+        }
+    }
+
+    int AdaptiveRates::baseRate(MutationOp op) const
+    { return m_base[op]; }
+
+    bool AdaptiveRates::scored(MutationOp op) const
+    { return m_trials[op] >= m_minTrials; }
+}
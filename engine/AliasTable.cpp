@@ -0,0 +1,83 @@
+/*
+ *  Evoimage-gl, a library and program to evolve images
+ *  Copyright (C) 2009 Brent Burton
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+#include "AliasTable.h"
+#include "Tools.h"
+
+namespace ei
+{
+    const uint32_t AliasTable::scale;
+
+    AliasTable::AliasTable()
+    { }
+
+    bool AliasTable::build(std::vector<double> const &weights)
+    {
+        int n = (int)weights.size();
+        double sum = 0;
+
+        m_threshold.clear();
+        m_alias.clear();
+        for (int i = 0; i < n; i++)
+            sum += weights[i] > 0 ? weights[i] : 0;
+        if (n == 0 || sum <= 0)
+            return false;
+
+        // Scale so the average bucket is exactly full, then pair each
+        // underfull bucket with an overfull one (Vose's method).
+        std::vector<double> scaled(n);
+        std::vector<int> small, large;
+        for (int i = 0; i < n; i++)
+        {
+            scaled[i] = (weights[i] > 0 ? weights[i] : 0) * n / sum;
+            (scaled[i] < 1.0 ? small : large).push_back(i);
+        }
+
+        m_threshold.assign(n, scale);
+        m_alias.resize(n);
+        for (int i = 0; i < n; i++)
+            m_alias[i] = i;
+
+        while (!small.empty() && !large.empty())
+        {
+            int s = small.back(), l = large.back();
+            small.pop_back();
+            m_threshold[s] = (uint32_t)(scaled[s] * scale);
+            m_alias[s] = l;
+            scaled[l] -= 1.0 - scaled[s];
+            if (scaled[l] < 1.0)
+            {
+                large.pop_back();
+                small.push_back(l);
+            }
+        }
+        // Whatever remains is full, up to rounding
+        return true;
+    }
+
+    bool AliasTable::empty() const
+    { return m_alias.empty(); }
+
+    int AliasTable::sample() const
+    {
+        int i = Tools::getRandomNumber(0, (int)m_alias.size() - 1);
+        if ((uint32_t)Tools::getRandomNumber(0, scale - 1) < m_threshold[i])
+            return i;
+        return m_alias[i];
+    }
+}
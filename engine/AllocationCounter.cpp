@@ -0,0 +1,137 @@
+/*
+ *  Evoimage-gl, a library and program to evolve images
+ *  Copyright (C) 2009 Brent Burton
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+#include <atomic>
+#include <new>
+#include <pthread.h>
+#include <stdlib.h>
+#include "AllocationCounter.h"
+
+namespace ei
+{
+    namespace AllocationCounter
+    {
+        // One per thread, linked into s_counters while the thread lives
+        struct ThreadCounter
+        {
+            std::atomic<uint64_t> count;
+            ThreadCounter *next;
+
+            ThreadCounter();
+            ~ThreadCounter();
+        };
+
+        static bool s_enabled = false;
+        static pthread_mutex_t s_lock = PTHREAD_MUTEX_INITIALIZER;
+        static ThreadCounter *s_counters = 0;   // every live thread's counter
+        static uint64_t s_retired = 0;          // counts of threads that exited
+        static thread_local ThreadCounter t_counter;
+
+        ThreadCounter::ThreadCounter()
+            : count(0)
+        {
+            pthread_mutex_lock(&s_lock);
+            next = s_counters;
+            s_counters = this;
+            pthread_mutex_unlock(&s_lock);
+        }
+
+        ThreadCounter::~ThreadCounter()
+        {
+            pthread_mutex_lock(&s_lock);
+            ThreadCounter **link = &s_counters;
+            while (*link != this)
+                link = &(*link)->next;
+            *link = next;
+            s_retired += count.load(std::memory_order_relaxed);
+            pthread_mutex_unlock(&s_lock);
+        }
+
+        void enable()
+        { s_enabled = true; }
+
+        bool enabled()
+        { return s_enabled; }
+
+        uint64_t count()
+        {
+            pthread_mutex_lock(&s_lock);
+            uint64_t total = s_retired;
+            for (ThreadCounter *c = s_counters; c; c = c->next)
+                total += c->count.load(std::memory_order_relaxed);
+            pthread_mutex_unlock(&s_lock);
+            return total;
+        }
+
+        static inline void *countedAlloc(size_t size)
+        {
+            if (s_enabled)
+            {
+                // Only this thread writes its counter, so no atomic add is needed
+                std::atomic<uint64_t> &count = t_counter.count;
+                count.store(count.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            }
+            return malloc(size ? size : 1);
+        }
+    }
+}
+
+/*
+ * The replacements, kept out of line so the compiler does not see
+ * malloc() or free() behind every new and delete.
+ */
+__attribute__((noinline)) void *operator new(size_t size)
+{
+    void *p = ei::AllocationCounter::countedAlloc(size);
+    if (!p)
+        throw std::bad_alloc();
+    return p;
+}
+
+__attribute__((noinline)) void *operator new[](size_t size)
+{
+    return operator new(size);
+}
+
+__attribute__((noinline)) void *operator new(size_t size, std::nothrow_t const &) noexcept
+{
+    return ei::AllocationCounter::countedAlloc(size);
+}
+
+__attribute__((noinline)) void *operator new[](size_t size, std::nothrow_t const &) noexcept
+{
+    return ei::AllocationCounter::countedAlloc(size);
+}
+
+__attribute__((noinline)) void operator delete(void *p) noexcept
+{ free(p); }
+
+__attribute__((noinline)) void operator delete[](void *p) noexcept
+{ free(p); }
+
+__attribute__((noinline)) void operator delete(void *p, std::nothrow_t const &) noexcept
+{ free(p); }
+
+__attribute__((noinline)) void operator delete[](void *p, std::nothrow_t const &) noexcept
+{ free(p); }
+
+__attribute__((noinline)) void operator delete(void *p, size_t) noexcept
+{ free(p); }
+
+__attribute__((noinline)) void operator delete[](void *p, size_t) noexcept
+{ free(p); }
@@ -0,0 +1,117 @@
+/*
+ *  Evoimage-gl, a library and program to evolve images
+ *  Copyright (C) 2009 Brent Burton
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+#include <cstring>
+#include "CairoRender.h"
+#include "DnaDrawing.h"
+#include "Tools.h"
+
+namespace ei
+{
+    namespace CairoRender
+    {
+        void drawPolygons(cairo_t *ctx, DnaDrawing *d, DnaRect const &clip)
+        {
+            DnaPolygonList &polys = d->polygons();
+            DnaPolygonList::iterator iter;
+            for (iter = polys.begin(); iter != polys.end(); iter++)
+            {
+                DnaPolygon &poly = *iter;
+                if (!poly.bounds().intersects(clip))
+                    continue;
+
+                // Create path:
+                DnaPointList &points = poly.points();
+                cairo_move_to(ctx, points[0].x, points[0].y);
+                for (size_t i = 1; i < points.size(); i++)
+                    cairo_line_to(ctx, points[i].x, points[i].y);
+                cairo_close_path(ctx);
+
+                DnaBrush &brush = poly.brush();
+                cairo_set_source_rgba(ctx,
+                                      brush.r / 255.0, brush.g / 255.0,
+                                      brush.b / 255.0, brush.a / 255.0);
+                cairo_fill(ctx);                // fill and consume path
+            }
+        }
+
+        cairo_surface_t *render(DnaDrawing *d, int width, int height)
+        {
+            cairo_surface_t *surface = cairo_image_surface_create(CAIRO_FORMAT_RGB24, width, height);
+            if (cairo_surface_status(surface) != CAIRO_STATUS_SUCCESS)
+            {
+                cairo_surface_destroy(surface);
+                return 0;
+            }
+
+            cairo_t *ctx = cairo_create(surface);
+            if (cairo_status(ctx) != CAIRO_STATUS_SUCCESS)
+            {
+                cairo_destroy(ctx);
+                cairo_surface_destroy(surface);
+                return 0;
+            }
+
+            // Clear to black, then draw in canvas coordinates
+            cairo_set_source_rgb(ctx, 0.0, 0.0, 0.0);
+            cairo_paint(ctx);
+            if (width != Tools::maxWidth || height != Tools::maxHeight)
+                cairo_scale(ctx, double(width) / Tools::maxWidth, double(height) / Tools::maxHeight);
+            drawPolygons(ctx, d, DnaRect(0, 0, Tools::maxWidth, Tools::maxHeight));
+            cairo_destroy(ctx);
+
+            cairo_surface_flush(surface);
+            return surface;
+        }
+
+        cairo_surface_t *renderOver(DnaDrawing *d, cairo_surface_t *base, DnaRect const &clip)
+        {
+            int width = cairo_image_surface_get_width(base);
+            int height = cairo_image_surface_get_height(base);
+            cairo_surface_t *surface = cairo_image_surface_create(CAIRO_FORMAT_RGB24, width, height);
+            if (cairo_surface_status(surface) != CAIRO_STATUS_SUCCESS)
+            {
+                cairo_surface_destroy(surface);
+                return 0;
+            }
+
+            cairo_surface_flush(base);
+            memcpy(cairo_image_surface_get_data(surface), cairo_image_surface_get_data(base),
+                   cairo_image_surface_get_stride(base) * height);
+            cairo_surface_mark_dirty(surface);
+
+            cairo_t *ctx = cairo_create(surface);
+            if (cairo_status(ctx) != CAIRO_STATUS_SUCCESS)
+            {
+                cairo_destroy(ctx);
+                cairo_surface_destroy(surface);
+                return 0;
+            }
+
+            cairo_rectangle(ctx, clip.x0, clip.y0, clip.x1 - clip.x0, clip.y1 - clip.y0);
+            cairo_clip(ctx);
+            cairo_set_source_rgb(ctx, 0.0, 0.0, 0.0);
+            cairo_paint(ctx);
+            drawPolygons(ctx, d, clip);
+            cairo_destroy(ctx);
+
+            cairo_surface_flush(surface);
+            return surface;
+        }
+    }
+}
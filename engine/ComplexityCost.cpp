@@ -0,0 +1,77 @@
+/*
+ *  Evoimage-gl, a library and program to evolve images
+ *  Copyright (C) 2009 Brent Burton
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+#include <algorithm>
+#include <cmath>
+#include "ComplexityCost.h"
+#include "DnaDrawing.h"
+
+namespace ei
+{
+    ComplexityCost::ComplexityCost(uint32_t polygonCost, uint32_t vertexCost, double areaBudget)
+        : m_polygonCost(polygonCost), m_vertexCost(vertexCost), m_areaBudget(areaBudget)
+    { }
+
+    bool ComplexityCost::enabled() const
+    {
+        return m_polygonCost > 0 || m_vertexCost > 0 || m_areaBudget > 0;
+    }
+
+    double ComplexityCost::area(DnaPolygon &polygon)
+    {
+        DnaPointList &points = polygon.points();
+        int64_t twice = 0;
+        for (size_t i = 0, n = points.size(); i < n; i++)
+        {
+            DnaPoint const &a = points[i], &b = points[(i + 1) % n];
+            twice += (int64_t)a.x * b.y - (int64_t)b.x * a.y;
+        }
+        return std::fabs(twice / 2.0);
+    }
+
+    double ComplexityCost::area(DnaDrawing &drawing)
+    {
+        double sum = 0;
+        DnaPolygonList &polygons = drawing.polygons();
+        for (size_t i = 0; i < polygons.size(); i++)
+            sum += area(polygons[i]);
+        return sum;
+    }
+
+    bool ComplexityCost::overBudget(DnaDrawing &drawing) const
+    {
+        return m_areaBudget > 0 && area(drawing) > m_areaBudget;
+    }
+
+    uint32_t ComplexityCost::score(DnaDrawing &drawing, uint32_t difference) const
+    {
+        if (m_areaBudget > 0)
+        {
+            double over = area(drawing) - m_areaBudget;
+            if (over > 0)
+                return overBudgetScore + (uint32_t)std::min(std::ceil(over), double(overBudgetScore - 1));
+        }
+
+        uint64_t sum = difference;
+        if (m_polygonCost > 0)
+            sum += (uint64_t)m_polygonCost * drawing.polygons().size();
+        if (m_vertexCost > 0)
+            sum += (uint64_t)m_vertexCost * drawing.pointCount();
+        return (uint32_t)std::min(sum, uint64_t(overBudgetScore - 1));
+    }
+}
@@ -53,25 +53,25 @@ namespace ei
         if (Tools::willMutate(Settings::activeRedMutationRate))
         {
             r = Tools::getRandomNumber(Settings::activeRedRangeMin, Settings::activeRedRangeMax);
-            drawing.setDirty();
+            drawing.setDirty(OpRed);
         }
 
         if (Tools::willMutate(Settings::activeGreenMutationRate))
         {
             g = Tools::getRandomNumber(Settings::activeGreenRangeMin, Settings::activeGreenRangeMax);
-            drawing.setDirty();
+            drawing.setDirty(OpGreen);
         }
 
         if (Tools::willMutate(Settings::activeBlueMutationRate))
         {
             b = Tools::getRandomNumber(Settings::activeBlueRangeMin, Settings::activeBlueRangeMax);
-            drawing.setDirty();
+            drawing.setDirty(OpBlue);
         }
 
         if (Tools::willMutate(Settings::activeAlphaMutationRate))
         {
             a = Tools::getRandomNumber(Settings::activeAlphaRangeMin, Settings::activeAlphaRangeMax);
-            drawing.setDirty();
+            drawing.setDirty(OpAlpha);
         }
     }
 }
@@ -0,0 +1,128 @@
+/*
+ *  Evoimage-gl, a library and program to evolve images
+ *  Copyright (C) 2009 Brent Burton
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+#include "DnaCodec.h"
+#include "DnaDrawing.h"
+#include "Tools.h"
+
+namespace ei
+{
+    static const size_t polygonHeaderSize = 5;
+    static const size_t pointSize = 4;
+    static const int minPoints = 3;         // fewer is not a polygon
+
+    static inline void put16(uint8_t *&p, int value)
+    {
+        p[0] = value & 0xff;
+        p[1] = (value >> 8) & 0xff;
+        p += 2;
+    }
+
+    static inline int get16(const uint8_t *&p)
+    {
+        int value = p[0] | (p[1] << 8);
+        p += 2;
+        return value;
+    }
+
+    size_t DnaCodec::maxSize(int polygons, int pointsPerPolygon)
+    {
+        return 2 + polygons * (polygonHeaderSize + pointsPerPolygon * pointSize);
+    }
+
+    size_t DnaCodec::encodedSize(DnaDrawing &drawing)
+    {
+        size_t size = 2;
+        for (auto &polygon: drawing.polygons())
+            size += polygonHeaderSize + polygon.pointCount() * pointSize;
+        return size;
+    }
+
+    size_t DnaCodec::encode(DnaDrawing &drawing, uint8_t *buffer, size_t capacity)
+    {
+        size_t size = encodedSize(drawing);
+        if (size > capacity || drawing.polygons().size() > 0xffff)
+            return 0;
+
+        uint8_t *p = buffer;
+        put16(p, drawing.polygons().size());
+        for (auto &polygon: drawing.polygons())
+        {
+            if (polygon.pointCount() > 0xff)
+                return 0;
+            *p++ = polygon.pointCount();
+            *p++ = polygon.brush().r;
+            *p++ = polygon.brush().g;
+            *p++ = polygon.brush().b;
+            *p++ = polygon.brush().a;
+            for (auto &point: polygon.points())
+            {
+                if (point.x < 0 || point.x > 0xffff || point.y < 0 || point.y > 0xffff)
+                    return 0;
+                put16(p, point.x);
+                put16(p, point.y);
+            }
+        }
+        return size;
+    }
+
+    DnaDrawing *DnaCodec::decode(const uint8_t *buffer, size_t size)
+    {
+        const uint8_t *p = buffer;
+        const uint8_t *end = buffer + size;
+        if (size < 2)
+            return 0;
+
+        // Check the count against the bytes before making that many polygons
+        int count = get16(p);
+        if ((size_t)(end - p) < count * (polygonHeaderSize + minPoints * pointSize))
+            return 0;
+        DnaPolygonList polygons(count);
+        for (auto &polygon: polygons)
+        {
+            if ((size_t)(end - p) < polygonHeaderSize)
+                return 0;
+            int points = *p++;
+            int r = *p++;
+            int g = *p++;
+            int b = *p++;
+            int a = *p++;
+            if (points < minPoints || (size_t)(end - p) < points * pointSize)
+                return 0;
+
+            DnaPointList list;
+            list.reserve(points);
+            for (int i = 0; i < points; i++)
+            {
+                int x = get16(p);
+                int y = get16(p);
+                if (x > Tools::maxWidth || y > Tools::maxHeight)
+                    return 0;
+                list.push_back(DnaPoint(x, y));
+            }
+            polygon.setPoints(list);
+            polygon.setBrush(DnaBrush(r, g, b, a));
+        }
+        if (p != end)
+            return 0;
+
+        DnaDrawing *drawing = new DnaDrawing();
+        drawing->setPolygons(polygons);
+        return drawing;
+    }
+}
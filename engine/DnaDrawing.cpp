@@ -18,15 +18,18 @@
  */
 #include <iostream>
 #include <algorithm>
+#include <cstring>
 #include "DnaDrawing.h"
 #include "Settings.h"
 #include "Tools.h"
+#include "Probes.h"
 
 namespace ei
 {
     DnaDrawing::DnaDrawing()
-        : m_dirty(true)
+        : m_dirty(true), m_changes(0)
     {
+        memset(m_opCounts, 0, sizeof(m_opCounts));
         init();
     }
 
@@ -51,7 +54,29 @@ namespace ei
     { return m_dirty; }
 
     void DnaDrawing::setDirty()
-    { m_dirty = true; }
+    {
+        m_dirty = true;
+        m_changes++;
+    }
+
+    void DnaDrawing::setDirty(MutationOp op)
+    {
+        setDirty();
+        m_opCounts[op]++;
+        EI_PROBE1(mutation, int(op));
+    }
+
+    unsigned DnaDrawing::opCount(MutationOp op)
+    { return m_opCounts[op]; }
+
+    DnaRect const &DnaDrawing::dirtyRect()
+    { return m_dirtyRect; }
+
+    void DnaDrawing::touch(DnaPolygon &polygon)
+    {
+        m_dirtyRect.unite(polygon.bounds());
+        polygon.setChanged(true);
+    }
 
     int DnaDrawing::pointCount()
     {
@@ -69,10 +94,22 @@ namespace ei
     DnaDrawing* DnaDrawing::clone()
     {
         DnaDrawing *dd = new DnaDrawing();
-        dd->m_polygons = m_polygons;
+        dd->copyFrom(*this);
         return dd;
     }
 
+    void DnaDrawing::copyFrom(DnaDrawing const &other)
+    {
+        m_polygons = other.m_polygons;
+        setDirty();
+        m_dirtyRect.clear();
+        memset(m_opCounts, 0, sizeof(m_opCounts));
+
+        DnaPolygonList::iterator iter;
+        for (iter = m_polygons.begin(); iter != m_polygons.end(); iter++)
+            iter->setChanged(false);
+    }
+
     void DnaDrawing::mutate()
     {
         if (Tools::willMutate(Settings::activeAddPolygonMutationRate))
@@ -90,10 +127,18 @@ namespace ei
             movePolygon();
         }
 
+        // A polygon that changed dirties both where it was and where it is
         DnaPolygonList::iterator iter;
         for (iter = m_polygons.begin(); iter != m_polygons.end(); iter++)
         {
+            DnaRect before = iter->bounds();
+            unsigned changes = m_changes;
             iter->mutate(*this);
+            if (changes != m_changes)
+            {
+                m_dirtyRect.unite(before);
+                touch(*iter);
+            }
         }
     }
 
@@ -102,6 +147,7 @@ namespace ei
         if (m_polygons.size() < Settings::activePolygonsMax)
         {
             DnaPolygon poly;
+            touch(poly);
             if (m_polygons.size() > 2)
             {
                 int index = Tools::getRandomNumber(0, m_polygons.size()-1);
@@ -111,7 +157,7 @@ namespace ei
             {
                 m_polygons.push_back(poly);
             }
-            setDirty();
+            setDirty(OpAddPolygon);
         }
     }
 
@@ -120,8 +166,9 @@ namespace ei
         if (m_polygons.size() > Settings::activePolygonsMin)
         {
             int index = Tools::getRandomNumber(0, m_polygons.size()-1);
+            touch(m_polygons[index]);
             m_polygons.erase(m_polygons.begin() + index);
-            setDirty();
+            setDirty(OpRemovePolygon);
         }
     }
 
@@ -134,8 +181,46 @@ namespace ei
         int a = Tools::getRandomNumber(0, m_polygons.size()-1),
             b = Tools::getRandomNumber(0, m_polygons.size()-1);
         if (a != b) {
+            touch(m_polygons[a]);
+            touch(m_polygons[b]);
             std::swap(m_polygons[a], m_polygons[b]);
-            setDirty();
+            setDirty(OpMovePolygon);
+        }
+    }
+
+    // Same color and vertices: swapping them changes no pixel
+    static bool samePolygon(DnaPolygon &a, DnaPolygon &b)
+    {
+        DnaBrush &ba = a.brush(), &bb = b.brush();
+        if (ba.r != bb.r || ba.g != bb.g || ba.b != bb.b || ba.a != bb.a ||
+            a.pointCount() != b.pointCount())
+            return false;
+        for (size_t i = 0; i < a.pointCount(); i++)
+        {
+            if (a.points()[i].x != b.points()[i].x || a.points()[i].y != b.points()[i].y)
+                return false;
         }
+        return true;
+    }
+
+    void DnaDrawing::crossover(DnaDrawing &other)
+    {
+        int n = std::min(m_polygons.size(), other.m_polygons.size());
+        if (n < 1)
+            return;
+
+        int a = Tools::getRandomNumber(0, n-1),
+            b = Tools::getRandomNumber(0, n-1);
+        if (a > b)
+            std::swap(a, b);
+        for (int i = a; i <= b; i++)
+        {
+            if (samePolygon(m_polygons[i], other.m_polygons[i]))
+                continue;
+            touch(m_polygons[i]);
+            m_polygons[i] = other.m_polygons[i];
+            touch(m_polygons[i]);
+        }
+        setDirty();
     }
 }
@@ -28,9 +28,9 @@ namespace ei
     { }
 
     DnaPoint::DnaPoint()
-        : x(Tools::getRandomNumber(0, Tools::maxWidth))
-        , y(Tools::getRandomNumber(0, Tools::maxHeight))
-    { }
+    {
+        Tools::getRandomPosition(x, y);
+    }
 
     DnaPoint DnaPoint::clone()
     {
@@ -41,35 +41,28 @@ namespace ei
     {
         if (Tools::willMutate(Settings::activeMovePointMaxMutationRate))
         {
-            x = Tools::getRandomNumber(0, Tools::maxWidth);
-            y = Tools::getRandomNumber(0, Tools::maxHeight);
-            drawing.setDirty();
+            Tools::getRandomPosition(x, y);
+            drawing.setDirty(OpMovePointMax);
         }
 
         if (Tools::willMutate(Settings::activeMovePointMidMutationRate))
         {
-            x = std::min( std::max(0,
-                                   x + Tools::getRandomNumber(-Settings::activeMovePointRangeMid,
-                                                              Settings::activeMovePointRangeMid)),
-                          Tools::maxWidth);
-            y = std::min( std::max(0,
-                                   y + Tools::getRandomNumber(-Settings::activeMovePointRangeMid,
-                                                              Settings::activeMovePointRangeMid)),
-                          Tools::maxHeight);
-            drawing.setDirty();
+            x += Tools::getRandomNumber(-Settings::activeMovePointRangeMid,
+                                        Settings::activeMovePointRangeMid);
+            y += Tools::getRandomNumber(-Settings::activeMovePointRangeMid,
+                                        Settings::activeMovePointRangeMid);
+            Tools::clampPosition(x, y);
+            drawing.setDirty(OpMovePointMid);
         }
 
         if (Tools::willMutate(Settings::activeMovePointMinMutationRate))
         {
-            x = std::min( std::max(0,
-                                   x + Tools::getRandomNumber(-Settings::activeMovePointRangeMin,
-                                                              Settings::activeMovePointRangeMin)),
-                          Tools::maxWidth);
-            y = std::min( std::max(0,
-                                   y + Tools::getRandomNumber(-Settings::activeMovePointRangeMin,
-                                                              Settings::activeMovePointRangeMin)),
-                          Tools::maxHeight);
-            drawing.setDirty();
+            x += Tools::getRandomNumber(-Settings::activeMovePointRangeMin,
+                                        Settings::activeMovePointRangeMin);
+            y += Tools::getRandomNumber(-Settings::activeMovePointRangeMin,
+                                        Settings::activeMovePointRangeMin);
+            Tools::clampPosition(x, y);
+            drawing.setDirty(OpMovePointMin);
         }
     }
 }
@@ -17,6 +17,7 @@
  *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
  */
 #include <iostream>
+#include <algorithm>
 #include "DnaPolygon.h"
 #include "Tools.h"
 #include "Settings.h"
@@ -25,6 +26,7 @@
 namespace ei
 {
     DnaPolygon::DnaPolygon()
+        : m_changed(false)
     {
         init();
     }
@@ -40,8 +42,9 @@ namespace ei
         for (int i=0; i < Settings::activePointsPerPolygonMin; i++)
         {
             int x, y;
-            x = std::min(std::max(0, origin.x + Tools::getRandomNumber(-3, 3)), Tools::maxWidth);
-            y = std::min(std::max(0, origin.y + Tools::getRandomNumber(-3, 3)), Tools::maxHeight);
+            x = origin.x + Tools::getRandomNumber(-3, 3);
+            y = origin.y + Tools::getRandomNumber(-3, 3);
+            Tools::clampPosition(x, y);
             m_points.push_back( DnaPoint(x, y) );
         }
 
@@ -79,6 +82,34 @@ namespace ei
         return m_points.size();
     }
 
+    bool DnaPolygon::changed()
+    { return m_changed; }
+
+    void DnaPolygon::setChanged(bool changed)
+    { m_changed = changed; }
+
+    DnaRect DnaPolygon::bounds()
+    {
+        if (m_points.empty())
+            return DnaRect();
+
+        DnaRect r(m_points[0].x, m_points[0].y, m_points[0].x, m_points[0].y);
+        DnaPointList::iterator iter;
+        for (iter = m_points.begin(); iter != m_points.end(); iter++)
+        {
+            r.x0 = std::min(r.x0, iter->x);
+            r.y0 = std::min(r.y0, iter->y);
+            r.x1 = std::max(r.x1, iter->x);
+            r.y1 = std::max(r.y1, iter->y);
+        }
+
+        // A vertex at x may partially cover pixels x-1 and x; the
+        // rectangle is half-open, so the far edge grows by two.
+        r.x0 -= 1;  r.y0 -= 1;
+        r.x1 += 2;  r.y1 += 2;
+        return r;
+    }
+
     void DnaPolygon::mutate(DnaDrawing &drawing)
     {
         if (Tools::willMutate(Settings::activeAddPointMutationRate))
@@ -107,7 +138,7 @@ namespace ei
         {
             int index = Tools::getRandomNumber(0, m_points.size()-1);
             m_points.erase(m_points.begin() + index);
-            drawing.setDirty();
+            drawing.setDirty(OpRemovePoint);
         }
     }
 
@@ -120,6 +151,7 @@ namespace ei
         if (m_points.size() < 3)
         {
             m_points.push_back(DnaPoint());
+            drawing.setDirty(OpAddPoint);
         }
         else
         {
@@ -131,7 +163,7 @@ namespace ei
             DnaPoint point( (prev.x + next.x)/2, (prev.y + next.y)/2 );
 
             m_points.insert(m_points.begin() + index, point);
-            drawing.setDirty();
+            drawing.setDirty(OpAddPoint);
         }
     }
 }
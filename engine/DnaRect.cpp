@@ -0,0 +1,59 @@
+/*
+ *  Evoimage-gl, a library and program to evolve images
+ *  Copyright (C) 2009 Brent Burton
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+#include <algorithm>
+#include "DnaRect.h"
+
+namespace ei
+{
+    DnaRect::DnaRect()
+        : x0(0), y0(0), x1(0), y1(0)
+    { }
+
+    DnaRect::DnaRect(int X0, int Y0, int X1, int Y1)
+        : x0(X0), y0(Y0), x1(X1), y1(Y1)
+    { }
+
+    bool DnaRect::empty() const
+    { return x0 >= x1 || y0 >= y1; }
+
+    bool DnaRect::intersects(DnaRect const &other) const
+    {
+        return (!empty() && !other.empty() &&
+                x0 < other.x1 && other.x0 < x1 &&
+                y0 < other.y1 && other.y0 < y1);
+    }
+
+    void DnaRect::clear()
+    { x0 = y0 = x1 = y1 = 0; }
+
+    void DnaRect::unite(DnaRect const &other)
+    {
+        if (other.empty())
+            return;
+        if (empty())
+        {
+            *this = other;
+            return;
+        }
+        x0 = std::min(x0, other.x0);
+        y0 = std::min(y0, other.y0);
+        x1 = std::max(x1, other.x1);
+        y1 = std::max(y1, other.y1);
+    }
+}
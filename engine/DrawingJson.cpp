@@ -0,0 +1,73 @@
+/*
+ *  Evoimage-gl, a library and program to evolve images
+ *  Copyright (C) 2009 Brent Burton
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+#include <fstream>
+#include <memory>
+#include "DrawingJson.h"
+#include "DnaDrawing.h"
+#include "Tools.h"
+
+namespace ei
+{
+    namespace DrawingJson
+    {
+        Json::Value toJson(DnaDrawing *drawing)
+        {
+            Json::Value polygons(Json::arrayValue);
+            for (auto &dnapoly: drawing->polygons())
+            {
+                Json::Value color;
+                color["r"] = dnapoly.brush().r / 255.0;
+                color["g"] = dnapoly.brush().g / 255.0;
+                color["b"] = dnapoly.brush().b / 255.0;
+                color["a"] = dnapoly.brush().a / 255.0;
+
+                Json::Value points(Json::arrayValue);
+                for (auto &dnapoint: dnapoly.points())
+                {
+                    Json::Value ptval;
+                    ptval["x"] = dnapoint.x / double(Tools::maxWidth);
+                    ptval["y"] = dnapoint.y / double(Tools::maxHeight);
+                    points.append(ptval);
+                }
+
+                Json::Value polygon;
+                polygon["color"] = color;
+                polygon["points"] = points;
+                polygons.append(polygon);
+            }
+
+            Json::Value drwg;
+            drwg["polygons"] = polygons;
+            return drwg;
+        }
+
+        bool save(DnaDrawing *drawing, std::string const &filename)
+        {
+            std::ofstream outfile(filename);
+            if (!outfile.is_open())
+                return false;
+
+            Json::StreamWriterBuilder builder;
+            builder["indentation"] = "    ";
+            std::unique_ptr<Json::StreamWriter> writer( builder.newStreamWriter() );
+            writer->write(toJson(drawing), &outfile);
+            return true;
+        }
+    }
+}
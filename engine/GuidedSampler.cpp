@@ -0,0 +1,53 @@
+/*
+ *  Evoimage-gl, a library and program to evolve images
+ *  Copyright (C) 2009 Brent Burton
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+#include <algorithm>
+#include "GuidedSampler.h"
+
+namespace ei
+{
+    GuidedSampler::GuidedSampler(int percent)
+        : m_percent(percent)
+    { }
+
+    void GuidedSampler::update(TileErrorMap const &errors)
+    {
+        std::vector<double> weights(errors.tilesX() * errors.tilesY());
+        for (int ty = 0; ty < errors.tilesY(); ty++)
+            for (int tx = 0; tx < errors.tilesX(); tx++)
+                weights[ty * errors.tilesX() + tx] = errors.error(tx, ty);
+
+        m_tiles = errors;
+        m_table.build(weights);
+    }
+
+    void GuidedSampler::sample(int &x, int &y)
+    {
+        if (m_table.empty() || Tools::getRandomNumber(0, 99) >= m_percent)
+        {
+            x = Tools::getRandomNumber(0, Tools::maxWidth);
+            y = Tools::getRandomNumber(0, Tools::maxHeight);
+            return;
+        }
+
+        int tile = m_table.sample();
+        DnaRect r = m_tiles.tileRect(tile % m_tiles.tilesX(), tile / m_tiles.tilesX());
+        x = std::min(Tools::getRandomNumber(r.x0, r.x1 - 1), Tools::maxWidth);
+        y = std::min(Tools::getRandomNumber(r.y0, r.y1 - 1), Tools::maxHeight);
+    }
+}
@@ -0,0 +1,307 @@
+/*
+ *  Evoimage-gl, a library and program to evolve images
+ *  Copyright (C) 2009 Brent Burton
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <vector>
+#include "Initializer.h"
+#include "DnaDrawing.h"
+#include "Settings.h"
+#include "TargetImage.h"
+
+namespace ei
+{
+    // Weight of distance against color difference in k-means, per
+    // cluster spacing; higher keeps clusters compact.
+    static const double compactness = 20.0;
+
+    // Polygons the active limits leave room for, at pointsEach points
+    static int polygonBudget(int polygons, int pointsEach)
+    {
+        polygons = std::min(polygons, Settings::activePolygonsMax);
+        polygons = std::min(polygons, Settings::activePointsMax / pointsEach);
+        return std::max(polygons, 1);
+    }
+
+    static DnaPolygon makePolygon(DnaPointList const &points, int r, int g, int b)
+    {
+        DnaPolygon polygon;
+        polygon.setPoints(points);
+        polygon.setBrush(DnaBrush(r, g, b, 255));
+        return polygon;
+    }
+
+    static long long cross(DnaPoint const &o, DnaPoint const &a, DnaPoint const &b)
+    {
+        return (long long)(a.x - o.x) * (b.y - o.y) - (long long)(a.y - o.y) * (b.x - o.x);
+    }
+
+    // Convex hull of points (which is reordered), counterclockwise
+    static DnaPointList convexHull(DnaPointList &points)
+    {
+        std::sort(points.begin(), points.end(), [](DnaPoint const &a, DnaPoint const &b)
+                  { return a.x < b.x || (a.x == b.x && a.y < b.y); });
+        DnaPointList hull;
+        hull.reserve(2 * points.size());
+        for (size_t i = 0; i < points.size(); i++)
+        {
+            while (hull.size() >= 2 && cross(hull[hull.size()-2], hull.back(), points[i]) <= 0)
+                hull.pop_back();
+            hull.push_back(points[i]);
+        }
+        for (size_t i = points.size() - 1, lower = hull.size() + 1; i-- > 0; )
+        {
+            while (hull.size() >= lower && cross(hull[hull.size()-2], hull.back(), points[i]) <= 0)
+                hull.pop_back();
+            hull.push_back(points[i]);
+        }
+        if (hull.size() > 1)
+            hull.pop_back();                // the first point, again
+        return hull;
+    }
+
+    // Bring a polygon within [minPoints,maxPoints]: drop the vertices
+    // spanning the least area, or split the longest edges.
+    static void fitPoints(DnaPointList &points, size_t minPoints, size_t maxPoints)
+    {
+        while (points.size() > maxPoints)
+        {
+            size_t n = points.size(), drop = 0;
+            long long least = LLONG_MAX;
+            for (size_t i = 0; i < n; i++)
+            {
+                long long area = std::llabs(cross(points[(i + n - 1) % n], points[i], points[(i + 1) % n]));
+                if (area < least)
+                {
+                    least = area;
+                    drop = i;
+                }
+            }
+            points.erase(points.begin() + drop);
+        }
+        while (points.size() < minPoints)
+        {
+            size_t n = points.size(), split = 0;
+            long long longest = -1;
+            for (size_t i = 0; i < n; i++)
+            {
+                DnaPoint const &a = points[i], &b = points[(i + 1) % n];
+                long long length = (long long)(a.x - b.x) * (a.x - b.x) + (long long)(a.y - b.y) * (a.y - b.y);
+                if (length > longest)
+                {
+                    longest = length;
+                    split = i;
+                }
+            }
+            DnaPoint const &a = points[split], &b = points[(split + 1) % n];
+            points.insert(points.begin() + split + 1, DnaPoint((a.x + b.x) / 2, (a.y + b.y) / 2));
+        }
+    }
+
+    DnaDrawing *Initializer::grid(TargetImage const &target, DnaRect const &area, int polygons)
+    {
+        int aw = area.x1 - area.x0, ah = area.y1 - area.y0;
+
+        // Cells are quads, or pairs of triangles if quads are not allowed
+        bool triangles = Settings::activePointsPerPolygonMax < 4;
+        int cells = triangles ? std::max(1, polygonBudget(polygons, 3) / 2) : polygonBudget(polygons, 4);
+        int columns = (int)std::lround(std::sqrt((double)cells * aw / ah));
+        columns = std::max(1, std::min(std::min(columns, cells), aw));
+        int rows = std::max(1, std::min(cells / columns, ah));
+
+        DnaPolygonList list;
+        for (int row = 0; row < rows; row++)
+        {
+            for (int column = 0; column < columns; column++)
+            {
+                int x0 = area.x0 + column * aw / columns, x1 = area.x0 + (column + 1) * aw / columns;
+                int y0 = area.y0 + row * ah / rows, y1 = area.y0 + (row + 1) * ah / rows;
+                int n = (x1 - x0) * (y1 - y0);
+                int r = target.regionSum(0, x0, y0, x1, y1) / n;
+                int g = target.regionSum(1, x0, y0, x1, y1) / n;
+                int b = target.regionSum(2, x0, y0, x1, y1) / n;
+
+                DnaPointList points;
+                points.push_back(DnaPoint(x0, y0));
+                points.push_back(DnaPoint(x1, y0));
+                points.push_back(DnaPoint(x1, y1));
+                if (triangles)
+                {
+                    list.push_back(makePolygon(points, r, g, b));
+                    points.erase(points.begin() + 1);
+                }
+                points.push_back(DnaPoint(x0, y1));
+                list.push_back(makePolygon(points, r, g, b));
+            }
+        }
+
+        DnaDrawing *drawing = new DnaDrawing();
+        drawing->setPolygons(list);
+        return drawing;
+    }
+
+    struct Cluster
+    {
+        double x, y, r, g, b;               // center
+        double sx, sy, sr, sg, sb;          // sums over the members of a round
+        int count;
+    };
+
+    DnaDrawing *Initializer::kmeans(TargetImage const &target, DnaRect const &area, int polygons,
+                                    int iterations)
+    {
+        // Cluster on the coarsest level that still has 32 pixels across
+        int level = 0;
+        while (level + 1 < target.levels() &&
+               (area.x1 - area.x0) >> (level + 1) >= 32 && (area.y1 - area.y0) >> (level + 1) >= 32)
+            level++;
+        int scale = 1 << level;
+        int lx0 = area.x0 / scale, ly0 = area.y0 / scale;
+        int lx1 = std::min(target.levelWidth(level), (area.x1 + scale - 1) / scale);
+        int ly1 = std::min(target.levelHeight(level), (area.y1 + scale - 1) / scale);
+        int lw = lx1 - lx0, lh = ly1 - ly0;
+
+        size_t minPoints = std::max(3, Settings::activePointsPerPolygonMin);
+        int k = std::min(polygonBudget(polygons, minPoints), lw * lh);
+        size_t maxPoints = std::max(minPoints, std::min((size_t)Settings::activePointsPerPolygonMax,
+                                                        (size_t)(Settings::activePointsMax / k)));
+
+        int stride = target.planeStride(PlaneR, level);
+        const uint8_t *planes[3];
+        for (int c = 0; c < 3; c++)
+            planes[c] = target.plane((TargetPlane)(PlaneR + c), level) + ly0 * stride + lx0;
+
+        // Start from centers spread evenly over a grid
+        std::vector<Cluster> clusters(k);
+        int kc = std::max(1, std::min(k, (int)std::lround(std::sqrt((double)k * lw / lh))));
+        int kr = (k + kc - 1) / kc;
+        for (int i = 0; i < k; i++)
+        {
+            int cell = (int)((long long)i * kc * kr / k);
+            Cluster &cl = clusters[i];
+            cl.x = (cell % kc + 0.5) * lw / kc;
+            cl.y = (cell / kc + 0.5) * lh / kr;
+            int offset = (int)cl.y * stride + (int)cl.x;
+            cl.r = planes[0][offset];
+            cl.g = planes[1][offset];
+            cl.b = planes[2][offset];
+        }
+
+        double spacing = std::sqrt((double)lw * lh / k);
+        double weight = (compactness / spacing) * (compactness / spacing);
+        std::vector<int> labels(lw * lh);
+        for (int round = 0; round < iterations; round++)
+        {
+            for (Cluster &cl : clusters)
+            {
+                cl.sx = cl.sy = cl.sr = cl.sg = cl.sb = 0;
+                cl.count = 0;
+            }
+            for (int y = 0; y < lh; y++)
+            {
+                for (int x = 0; x < lw; x++)
+                {
+                    int offset = y * stride + x;
+                    double r = planes[0][offset], g = planes[1][offset], b = planes[2][offset];
+                    int best = 0;
+                    double bestDistance = 1e300;
+                    for (int i = 0; i < k; i++)
+                    {
+                        Cluster const &cl = clusters[i];
+                        double d = (r - cl.r) * (r - cl.r) + (g - cl.g) * (g - cl.g) + (b - cl.b) * (b - cl.b) +
+                                   weight * ((x + 0.5 - cl.x) * (x + 0.5 - cl.x) + (y + 0.5 - cl.y) * (y + 0.5 - cl.y));
+                        if (d < bestDistance)
+                        {
+                            bestDistance = d;
+                            best = i;
+                        }
+                    }
+                    labels[y * lw + x] = best;
+                    Cluster &cl = clusters[best];
+                    cl.sx += x + 0.5;
+                    cl.sy += y + 0.5;
+                    cl.sr += r;
+                    cl.sg += g;
+                    cl.sb += b;
+                    cl.count++;
+                }
+            }
+            for (Cluster &cl : clusters)
+            {
+                if (cl.count == 0)
+                    continue;
+                cl.x = cl.sx / cl.count;
+                cl.y = cl.sy / cl.count;
+                cl.r = cl.sr / cl.count;
+                cl.g = cl.sg / cl.count;
+                cl.b = cl.sb / cl.count;
+            }
+        }
+
+        // The extent of each cluster on each row outlines it
+        std::vector<int> left(k * lh, INT_MAX), right(k * lh, -1);
+        for (int y = 0; y < lh; y++)
+        {
+            for (int x = 0; x < lw; x++)
+            {
+                int i = labels[y * lw + x] * lh + y;
+                left[i] = std::min(left[i], x);
+                right[i] = std::max(right[i], x);
+            }
+        }
+
+        // Largest first, so smaller clusters paint over their neighbors' hulls
+        std::vector<int> order(k);
+        for (int i = 0; i < k; i++)
+            order[i] = i;
+        std::stable_sort(order.begin(), order.end(), [&clusters](int a, int b)
+                         { return clusters[a].count > clusters[b].count; });
+
+        DnaPolygonList list;
+        for (int i : order)
+        {
+            Cluster const &cl = clusters[i];
+            if (cl.count == 0)
+                continue;
+
+            DnaPointList corners;
+            for (int y = 0; y < lh; y++)
+            {
+                if (right[i * lh + y] < 0)
+                    continue;
+                int x0 = std::max(area.x0, (lx0 + left[i * lh + y]) * scale);
+                int x1 = std::min(area.x1, (lx0 + right[i * lh + y] + 1) * scale);
+                int y0 = std::max(area.y0, (ly0 + y) * scale);
+                int y1 = std::min(area.y1, (ly0 + y + 1) * scale);
+                corners.push_back(DnaPoint(x0, y0));
+                corners.push_back(DnaPoint(x0, y1));
+                corners.push_back(DnaPoint(x1, y0));
+                corners.push_back(DnaPoint(x1, y1));
+            }
+            DnaPointList hull = convexHull(corners);
+            fitPoints(hull, minPoints, maxPoints);
+            list.push_back(makePolygon(hull, (int)std::lround(cl.r), (int)std::lround(cl.g),
+                                       (int)std::lround(cl.b)));
+        }
+
+        DnaDrawing *drawing = new DnaDrawing();
+        drawing->setPolygons(list);
+        return drawing;
+    }
+}
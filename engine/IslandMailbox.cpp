@@ -0,0 +1,113 @@
+/*
+ *  Evoimage-gl, a library and program to evolve images
+ *  Copyright (C) 2009 Brent Burton
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+#include <string.h>
+#include <sys/mman.h>
+#include <vector>
+#include "IslandMailbox.h"
+#include "DnaCodec.h"
+#include "DnaDrawing.h"
+
+namespace ei
+{
+    IslandMailbox::IslandMailbox()
+        : m_block(0), m_blockSize(0), m_slotSize(0), m_capacity(0), m_slots(0)
+    { }
+
+    IslandMailbox::~IslandMailbox()
+    {
+        close();
+    }
+
+    bool IslandMailbox::create(int islands, int polygons, int pointsPerPolygon)
+    {
+        close();
+
+        // Slots start on their own cache lines so owners do not contend
+        m_capacity = DnaCodec::maxSize(polygons, pointsPerPolygon);
+        m_slotSize = (sizeof(IslandSlot) + m_capacity + 63) & ~(size_t)63;
+        m_blockSize = m_slotSize * islands;
+
+        void *p = mmap(0, m_blockSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+        if (p == MAP_FAILED)
+            return false;
+
+        // Fresh zeroes are valid initial slots: no drawing, nothing done
+        m_block = static_cast<uint8_t *>(p);
+        m_slots = islands;
+        for (int i = 0; i < islands; i++)
+        {
+            slot(i).difference.store(UINT32_MAX, std::memory_order_relaxed);
+            slot(i).fitness.store(UINT32_MAX, std::memory_order_relaxed);
+        }
+        return true;
+    }
+
+    void IslandMailbox::close()
+    {
+        if (m_block)
+            munmap(m_block, m_blockSize);
+        m_block = 0;
+        m_slots = 0;
+    }
+
+    int IslandMailbox::islands() const
+    { return m_slots; }
+
+    IslandSlot &IslandMailbox::slot(int island)
+    { return *reinterpret_cast<IslandSlot *>(m_block + island * m_slotSize); }
+
+    uint8_t *IslandMailbox::drawingData(int island)
+    { return m_block + island * m_slotSize + sizeof(IslandSlot); }
+
+    bool IslandMailbox::post(int island, DnaDrawing &drawing)
+    {
+        IslandSlot &s = slot(island);
+        uint32_t seq = s.sequence.load(std::memory_order_relaxed);
+        s.sequence.store(seq + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        size_t size = DnaCodec::encode(drawing, drawingData(island), m_capacity);
+        s.size = size;
+        s.sequence.store(seq + 2, std::memory_order_release);
+        if (size > 0)
+            s.posted.fetch_add(1, std::memory_order_release);
+        return size > 0;
+    }
+
+    DnaDrawing *IslandMailbox::take(int island, uint32_t &serial)
+    {
+        IslandSlot &s = slot(island);
+        uint32_t posted = s.posted.load(std::memory_order_acquire);
+        if (posted == 0 || posted == serial)
+            return 0;
+
+        uint32_t before = s.sequence.load(std::memory_order_acquire);
+        if (before & 1)
+            return 0;
+        uint32_t size = s.size;
+        if (size > m_capacity)
+            return 0;
+        std::vector<uint8_t> copy(drawingData(island), drawingData(island) + size);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (before != s.sequence.load(std::memory_order_relaxed))
+            return 0;
+
+        serial = posted;
+        return DnaCodec::decode(copy.data(), copy.size());
+    }
+}
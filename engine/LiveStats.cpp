@@ -0,0 +1,136 @@
+/*
+ *  Evoimage-gl, a library and program to evolve images
+ *  Copyright (C) 2009 Brent Burton
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+#include <fcntl.h>
+#include <unistd.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "LiveStats.h"
+
+namespace ei
+{
+    const uint32_t LiveStats::version = 1;
+
+    static const char liveStatsMagic[8] = "EISTATS";
+
+    LiveStats::LiveStats()
+        : m_block(0), m_fd(-1)
+    {
+        memset(&m_data, 0, sizeof(m_data));
+    }
+
+    LiveStats::~LiveStats()
+    {
+        close();
+    }
+
+    bool LiveStats::open(const char *filename)
+    {
+        close();
+
+        m_fd = ::open(filename, O_RDWR | O_CREAT | O_TRUNC, 0644);
+        if (m_fd < 0)
+            return false;
+        if (0 != ftruncate(m_fd, sizeof(LiveStatsBlock)))
+        {
+            close();
+            return false;
+        }
+
+        void *p = mmap(0, sizeof(LiveStatsBlock), PROT_READ | PROT_WRITE, MAP_SHARED, m_fd, 0);
+        if (p == MAP_FAILED)
+        {
+            close();
+            return false;
+        }
+
+        // The file is fresh zeroes; the magic goes in last, once the rest is valid
+        m_block = static_cast<LiveStatsBlock *>(p);
+        m_block->version = version;
+        m_block->pid = getpid();
+        m_block->sequence.store(0, std::memory_order_relaxed);
+        publish();
+        std::atomic_thread_fence(std::memory_order_release);
+        memcpy(m_block->magic, liveStatsMagic, sizeof(m_block->magic));
+        return true;
+    }
+
+    void LiveStats::close()
+    {
+        if (m_block)
+            munmap(m_block, sizeof(LiveStatsBlock));
+        if (m_fd >= 0)
+            ::close(m_fd);
+        m_block = 0;
+        m_fd = -1;
+    }
+
+    bool LiveStats::isOpen() const
+    { return m_block != 0; }
+
+    LiveStatsData &LiveStats::data()
+    { return m_data; }
+
+    void LiveStats::publish()
+    {
+        if (!m_block)
+            return;
+
+        uint32_t seq = m_block->sequence.load(std::memory_order_relaxed);
+        m_block->sequence.store(seq + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        memcpy(&m_block->data, &m_data, sizeof(m_data));
+        m_block->sequence.store(seq + 2, std::memory_order_release);
+    }
+
+    bool LiveStats::read(const char *filename, LiveStatsData &data, uint32_t &pid)
+    {
+        int fd = ::open(filename, O_RDONLY);
+        if (fd < 0)
+            return false;
+
+        struct stat st;
+        void *p = MAP_FAILED;
+        if (0 == fstat(fd, &st) && st.st_size >= (off_t)sizeof(LiveStatsBlock))
+            p = mmap(0, sizeof(LiveStatsBlock), PROT_READ, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (p == MAP_FAILED)
+            return false;
+
+        LiveStatsBlock *block = static_cast<LiveStatsBlock *>(p);
+        bool ok = false;
+        if (0 == memcmp(block->magic, liveStatsMagic, sizeof(block->magic)) &&
+            block->version == version)
+        {
+            for (int attempt = 0; attempt < 1000 && !ok; attempt++)
+            {
+                uint32_t before = block->sequence.load(std::memory_order_acquire);
+                if (before & 1)
+                    continue;
+                memcpy(&data, &block->data, sizeof(data));
+                std::atomic_thread_fence(std::memory_order_acquire);
+                ok = before == block->sequence.load(std::memory_order_relaxed);
+            }
+            pid = block->pid;
+        }
+
+        munmap(p, sizeof(LiveStatsBlock));
+        return ok;
+    }
+}
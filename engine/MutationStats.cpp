@@ -0,0 +1,81 @@
+/*
+ *  Evoimage-gl, a library and program to evolve images
+ *  Copyright (C) 2009 Brent Burton
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+#include <cstring>
+#include "MutationStats.h"
+#include "DnaDrawing.h"
+
+namespace ei
+{
+    MutationStats::MutationStats()
+    {
+        reset();
+    }
+
+    void MutationStats::reset()
+    {
+        memset(m_ops, 0, sizeof(m_ops));
+        m_children = 0;
+        m_accepted = 0;
+    }
+
+    void MutationStats::add(MutationStats const &other)
+    {
+        for (int i = 0; i < MutationOpCount; i++)
+        {
+            m_ops[i].fired += other.m_ops[i].fired;
+            m_ops[i].children += other.m_ops[i].children;
+            m_ops[i].accepted += other.m_ops[i].accepted;
+            m_ops[i].improvement += other.m_ops[i].improvement;
+        }
+        m_children += other.m_children;
+        m_accepted += other.m_accepted;
+    }
+
+    void MutationStats::record(DnaDrawing &child, bool accepted, uint32_t improvement)
+    {
+        m_children++;
+        if (accepted)
+            m_accepted++;
+
+        for (int i = 0; i < MutationOpCount; i++)
+        {
+            unsigned count = child.opCount(MutationOp(i));
+            if (count == 0)
+                continue;
+
+            MutationOpStats &stats = m_ops[i];
+            stats.fired += count;
+            stats.children++;
+            if (accepted)
+            {
+                stats.accepted++;
+                stats.improvement += improvement;
+            }
+        }
+    }
+
+    MutationOpStats const &MutationStats::op(MutationOp op) const
+    { return m_ops[op]; }
+
+    uint64_t MutationStats::children() const
+    { return m_children; }
+
+    uint64_t MutationStats::accepted() const
+    { return m_accepted; }
+}
@@ -0,0 +1,90 @@
+/*
+ *  Evoimage-gl, a library and program to evolve images
+ *  Copyright (C) 2009 Brent Burton
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+#include <cstring>
+#include "PhaseProfiler.h"
+
+namespace ei
+{
+    const char *profilePhaseName(ProfilePhase phase)
+    {
+        static const char *names[PhaseCount] =
+        {
+            "clone",
+            "mutate",
+            "render",
+            "diff",
+            "select",
+            "snapshot"
+        };
+        return (phase >= 0 && phase < PhaseCount) ? names[phase] : "unknown";
+    }
+
+    PhaseProfiler::PhaseProfiler()
+        : m_active(0), m_start(Clock::now()), m_intervalStart(m_start), m_allocationBase(0)
+    {
+        memset(&m_current, 0, sizeof(m_current));
+        memset(&m_interval, 0, sizeof(m_interval));
+        memset(&m_total, 0, sizeof(m_total));
+    }
+
+    void PhaseProfiler::add(ProfilePhase phase, Clock::duration elapsed)
+    {
+        m_current.ns[phase] += std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count();
+        m_current.calls[phase]++;
+    }
+
+    void PhaseProfiler::countGeneration(unsigned children, bool accepted)
+    {
+        m_current.generations++;
+        m_current.children += children;
+        m_current.accepted += accepted;
+    }
+
+    void PhaseProfiler::endInterval(uint64_t allocations)
+    {
+        Clock::time_point now = Clock::now();
+        m_interval = m_current;
+        m_interval.seconds = std::chrono::duration<double>(now - m_intervalStart).count();
+        m_interval.allocations = allocations - m_allocationBase;
+
+        for (int i = 0; i < PhaseCount; i++)
+        {
+            m_total.ns[i] += m_interval.ns[i];
+            m_total.calls[i] += m_interval.calls[i];
+        }
+        m_total.seconds = std::chrono::duration<double>(now - m_start).count();
+        m_total.generations += m_interval.generations;
+        m_total.children += m_interval.children;
+        m_total.accepted += m_interval.accepted;
+        m_total.allocations += m_interval.allocations;
+
+        memset(&m_current, 0, sizeof(m_current));
+        m_intervalStart = now;
+        m_allocationBase = allocations;
+    }
+
+    PhaseProfiler::Totals const &PhaseProfiler::interval() const
+    { return m_interval; }
+
+    PhaseProfiler::Totals const &PhaseProfiler::total() const
+    { return m_total; }
+
+    PhaseProfiler::Totals const &PhaseProfiler::current() const
+    { return m_current; }
+}
@@ -0,0 +1,49 @@
+/*
+ *  Evoimage-gl, a library and program to evolve images
+ *  Copyright (C) 2009 Brent Burton
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+#include "PlateauDetector.h"
+
+namespace ei
+{
+    PlateauDetector::PlateauDetector(int window, double minGain)
+        : m_history(window > 0 ? window : 1), m_next(0), m_count(0), m_minGain(minGain)
+    { }
+
+    void PlateauDetector::reset()
+    {
+        m_next = 0;
+        m_count = 0;
+    }
+
+    bool PlateauDetector::update(uint32_t difference)
+    {
+        // The slot about to be overwritten holds the value window generations ago
+        uint32_t oldest = m_history[m_next];
+        bool full = m_count == m_history.size();
+
+        m_history[m_next] = difference;
+        m_next = (m_next + 1) % m_history.size();
+        if (!full)
+        {
+            m_count++;
+            return false;
+        }
+        return oldest <= difference ||
+               double(oldest - difference) < m_minGain * oldest;
+    }
+}
@@ -50,6 +50,25 @@ namespace ei
     int Settings::activeRemovePointMutationRate = 1500;
     int Settings::activeRemovePolygonMutationRate = 1500;
 
+    int &Settings::activeMutationRate(MutationOp op)
+    {
+        switch (op)
+        {
+          case OpAddPolygon:    return activeAddPolygonMutationRate;
+          case OpRemovePolygon: return activeRemovePolygonMutationRate;
+          case OpMovePolygon:   return activeMovePolygonMutationRate;
+          case OpAddPoint:      return activeAddPointMutationRate;
+          case OpRemovePoint:   return activeRemovePointMutationRate;
+          case OpMovePointMax:  return activeMovePointMaxMutationRate;
+          case OpMovePointMid:  return activeMovePointMidMutationRate;
+          case OpMovePointMin:  return activeMovePointMinMutationRate;
+          case OpRed:           return activeRedMutationRate;
+          case OpGreen:         return activeGreenMutationRate;
+          case OpBlue:          return activeBlueMutationRate;
+          default:              return activeAlphaMutationRate;
+        }
+    }
+
     Settings::Settings()
     {
         reset();
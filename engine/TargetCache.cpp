@@ -0,0 +1,94 @@
+/*
+ *  Evoimage-gl, a library and program to evolve images
+ *  Copyright (C) 2009 Brent Burton
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+#include <stdio.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "TargetCache.h"
+
+namespace ei
+{
+    TargetCache::TargetCache(std::string const &directory)
+        : m_directory(directory)
+    { }
+
+    bool TargetCache::hashFile(const char *filename, uint64_t &hash)
+    {
+        FILE *infp = fopen(filename, "rb");
+        if (infp == NULL)
+            return false;
+
+        unsigned char buffer[65536];
+        size_t count;
+        hash = 14695981039346656037ULL;     // FNV-1a offset basis
+        while (0 < (count = fread(buffer, 1, sizeof(buffer), infp)))
+        {
+            for (size_t i = 0; i < count; i++)
+            {
+                hash ^= buffer[i];
+                hash *= 1099511628211ULL;   // FNV prime
+            }
+        }
+        bool ok = !ferror(infp);
+        fclose(infp);
+        return ok;
+    }
+
+    std::string TargetCache::entryFor(const char *sourceFilename,
+                                      int width, int height, int tileSize)
+    {
+        uint64_t hash;
+        if (!hashFile(sourceFilename, hash))
+            return "";
+
+        char name[128];
+        snprintf(name, sizeof(name), "%016llx-v%u-%dx%d-t%d.target",
+                 (unsigned long long)hash, TargetImage::formatVersion,
+                 width, height, tileSize);
+        return m_directory + "/" + name;
+    }
+
+    bool TargetCache::load(std::string const &entry, TargetImage &target)
+    {
+        return target.map(entry.c_str());
+    }
+
+    bool TargetCache::store(std::string const &entry, TargetImage const &target)
+    {
+        if (0 != mkdir(m_directory.c_str(), 0777) && errno != EEXIST)
+            return false;
+
+        // Write privately, then rename into place atomically, so other
+        // processes never map a partial entry.
+        char suffix[32];
+        snprintf(suffix, sizeof(suffix), ".tmp%ld", (long)getpid());
+        std::string temp = entry + suffix;
+        if (!target.save(temp.c_str()))
+        {
+            unlink(temp.c_str());
+            return false;
+        }
+        if (0 != rename(temp.c_str(), entry.c_str()))
+        {
+            unlink(temp.c_str());
+            return false;
+        }
+        return true;
+    }
+}
@@ -0,0 +1,513 @@
+/*
+ *  Evoimage-gl, a library and program to evolve images
+ *  Copyright (C) 2009 Brent Burton
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <cstdio>
+#include <utility>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "TargetImage.h"
+
+namespace ei
+{
+    const uint32_t TargetImage::formatVersion = 1;
+
+    // Full range BT.601 in 8.8 fixed point. Inputs are 0..255, so
+    // the chroma terms stay within 0..255 after the +128 bias.
+    static inline int lumaOf(int r, int g, int b)
+    { return (77*r + 150*g + 29*b + 128) >> 8; }
+
+    static inline int cbOf(int r, int g, int b)
+    { return ((-43*r - 85*g + 128*b + 128) >> 8) + 128; }
+
+    static inline int crOf(int r, int g, int b)
+    { return ((128*r - 107*g - 21*b + 128) >> 8) + 128; }
+
+    static inline size_t alignUp(size_t n)
+    { return (n + TargetImage::alignment - 1) & ~(size_t)(TargetImage::alignment - 1); }
+
+    // On-disk header. The arena follows at headerSize, so a mapped
+    // arena keeps the page (and so cache line) alignment of the file.
+    static const size_t headerSize = 4096;
+
+    struct FileHeader
+    {
+        char     magic[8];
+        uint32_t version;
+        uint32_t width;
+        uint32_t height;
+        uint32_t tileSize;
+        uint64_t arenaSize;
+    };
+
+    static const char fileMagic[8] = {'E','I','T','A','R','G','E','T'};
+
+    TargetImage::TargetImage()
+        : m_width(0), m_height(0), m_tileSize(0)
+        , m_lumaWeight(1), m_chromaWeight(1)
+        , m_arena(0), m_ownsArena(false)
+        , m_mapping(0), m_mappingSize(0)
+    {
+        memset(&m_layout, 0, sizeof(m_layout));
+    }
+
+    TargetImage::~TargetImage()
+    {
+        release();
+    }
+
+    void TargetImage::release()
+    {
+        if (m_ownsArena)
+            free(m_arena);
+        if (m_mapping)
+            munmap(m_mapping, m_mappingSize);
+        m_arena = 0;
+        m_ownsArena = false;
+        m_mapping = 0;
+        m_mappingSize = 0;
+    }
+
+    void TargetImage::swap(TargetImage &other)
+    {
+        std::swap(m_width, other.m_width);
+        std::swap(m_height, other.m_height);
+        std::swap(m_tileSize, other.m_tileSize);
+        std::swap(m_lumaWeight, other.m_lumaWeight);
+        std::swap(m_chromaWeight, other.m_chromaWeight);
+        std::swap(m_layout, other.m_layout);
+        std::swap(m_arena, other.m_arena);
+        std::swap(m_ownsArena, other.m_ownsArena);
+        std::swap(m_mapping, other.m_mapping);
+        std::swap(m_mappingSize, other.m_mappingSize);
+    }
+
+    void TargetImage::computeLayout(int width, int height, int tileSize)
+    {
+        Layout &l = m_layout;
+        size_t offset = 0;
+
+        memset(&l, 0, sizeof(l));
+
+        // Pyramid: halve until a level would drop below 8 pixels
+        l.levels = 0;
+        int w = width, h = height;
+        while (l.levels < maxLevels)
+        {
+            l.levelWidth[l.levels] = w;
+            l.levelHeight[l.levels] = h;
+            l.levelStride[l.levels] = (int)alignUp(w);
+            for (int c = 0; c < 3; c++)
+            {
+                l.rgbOffset[l.levels][c] = offset;
+                offset += alignUp((size_t)l.levelStride[l.levels] * h);
+            }
+            l.levels++;
+            if (w < 16 || h < 16)
+                break;
+            w = (w + 1) / 2;
+            h = (h + 1) / 2;
+        }
+
+        l.yOffset = offset;
+        offset += alignUp((size_t)l.levelStride[0] * height);
+
+        l.chromaWidth = (width + 1) / 2;
+        l.chromaHeight = (height + 1) / 2;
+        l.chromaStride = (int)alignUp(l.chromaWidth);
+        l.cbOffset = offset;
+        offset += alignUp((size_t)l.chromaStride * l.chromaHeight);
+        l.crOffset = offset;
+        offset += alignUp((size_t)l.chromaStride * l.chromaHeight);
+
+        for (int c = 0; c < 3; c++)
+        {
+            l.integralOffset[c] = offset;
+            offset += alignUp(sizeof(uint32_t) * (width + 1) * (height + 1));
+        }
+
+        l.tilesX = (width + tileSize - 1) / tileSize;
+        l.tilesY = (height + tileSize - 1) / tileSize;
+        l.tileOffset = offset;
+        offset += alignUp(sizeof(TileStats) * l.tilesX * l.tilesY);
+
+        l.size = offset;
+    }
+
+    uint8_t *TargetImage::planeData(TargetPlane p, int level)
+    {
+        switch (p)
+        {
+          case PlaneR:  return m_arena + m_layout.rgbOffset[level][0];
+          case PlaneG:  return m_arena + m_layout.rgbOffset[level][1];
+          case PlaneB:  return m_arena + m_layout.rgbOffset[level][2];
+          case PlaneY:  return m_arena + m_layout.yOffset;
+          case PlaneCb: return m_arena + m_layout.cbOffset;
+          case PlaneCr: return m_arena + m_layout.crOffset;
+          default:      return 0;
+        }
+    }
+
+    uint32_t *TargetImage::integralData(int channel)
+    {
+        return (uint32_t*)(m_arena + m_layout.integralOffset[channel]);
+    }
+
+    bool TargetImage::load(const uint8_t *bgrx, int width, int height, int stride,
+                           int tileSize)
+    {
+        if (!bgrx || width < 1 || height < 1 || tileSize < 1)
+            return false;
+
+        release();
+        computeLayout(width, height, tileSize);
+        void *mem = 0;
+        if (0 != posix_memalign(&mem, alignment, m_layout.size))
+            return false;
+        m_arena = (uint8_t*)mem;
+        m_ownsArena = true;
+        memset(m_arena, 0, m_layout.size);
+
+        m_width = width;
+        m_height = height;
+        m_tileSize = tileSize;
+
+        // Level 0: de-interleave BGRX into R, G, B and Y
+        int ls = m_layout.levelStride[0];
+        uint8_t *pr = planeData(PlaneR, 0), *pg = planeData(PlaneG, 0);
+        uint8_t *pb = planeData(PlaneB, 0), *py = planeData(PlaneY, 0);
+        for (int y = 0; y < height; y++)
+        {
+            const uint8_t *row = bgrx + y * stride;
+            for (int x = 0; x < width; x++)
+            {
+                const uint8_t *p = row + x * 4;
+                pr[y*ls + x] = p[2];
+                pg[y*ls + x] = p[1];
+                pb[y*ls + x] = p[0];
+                py[y*ls + x] = lumaOf(p[2], p[1], p[0]);
+            }
+        }
+
+        // Pyramid levels: each is the 2x2 average of the one above it,
+        // reusing the last row/column on odd edges.
+        for (int level = 1; level < m_layout.levels; level++)
+        {
+            int sw = m_layout.levelWidth[level-1], sh = m_layout.levelHeight[level-1];
+            int ss = m_layout.levelStride[level-1];
+            int dw = m_layout.levelWidth[level], dh = m_layout.levelHeight[level];
+            int ds = m_layout.levelStride[level];
+            for (int c = 0; c < 3; c++)
+            {
+                const uint8_t *src = planeData((TargetPlane)(PlaneR + c), level-1);
+                uint8_t *dst = planeData((TargetPlane)(PlaneR + c), level);
+                for (int y = 0; y < dh; y++)
+                {
+                    const uint8_t *rowA = src + (2*y) * ss;
+                    const uint8_t *rowB = src + std::min(2*y + 1, sh - 1) * ss;
+                    for (int x = 0; x < dw; x++)
+                    {
+                        int xa = 2*x, xb = std::min(xa + 1, sw - 1);
+                        dst[y*ds + x] = (rowA[xa] + rowA[xb] + rowB[xa] + rowB[xb] + 2) >> 2;
+                    }
+                }
+            }
+        }
+
+        // Chroma is taken from the average of each 2x2 block. Odd edges
+        // reuse the last row/column, the same as differenceYcc() does.
+        int cs = m_layout.chromaStride;
+        uint8_t *pcb = planeData(PlaneCb, 0), *pcr = planeData(PlaneCr, 0);
+        for (int cy = 0; cy < m_layout.chromaHeight; cy++)
+        {
+            int ya = 2*cy, yb = std::min(2*cy + 1, height - 1);
+            for (int cx = 0; cx < m_layout.chromaWidth; cx++)
+            {
+                int xa = 2*cx, xb = std::min(2*cx + 1, width - 1);
+                int r = (pr[ya*ls+xa] + pr[ya*ls+xb] + pr[yb*ls+xa] + pr[yb*ls+xb] + 2) >> 2;
+                int g = (pg[ya*ls+xa] + pg[ya*ls+xb] + pg[yb*ls+xa] + pg[yb*ls+xb] + 2) >> 2;
+                int b = (pb[ya*ls+xa] + pb[ya*ls+xb] + pb[yb*ls+xa] + pb[yb*ls+xb] + 2) >> 2;
+                pcb[cy*cs + cx] = cbOf(r, g, b);
+                pcr[cy*cs + cx] = crOf(r, g, b);
+            }
+        }
+
+        // Summed area tables: entry (x,y) holds the sum of [0,x) x [0,y)
+        int is = width + 1;
+        for (int c = 0; c < 3; c++)
+        {
+            const uint8_t *src = planeData((TargetPlane)(PlaneR + c), 0);
+            uint32_t *sat = integralData(c);
+            for (int y = 0; y < height; y++)
+            {
+                uint32_t rowSum = 0;
+                for (int x = 0; x < width; x++)
+                {
+                    rowSum += src[y*ls + x];
+                    sat[(y+1)*is + (x+1)] = sat[y*is + (x+1)] + rowSum;
+                }
+            }
+        }
+
+        // Tile statistics
+        TileStats *tiles = (TileStats*)(m_arena + m_layout.tileOffset);
+        for (int ty = 0; ty < m_layout.tilesY; ty++)
+        {
+            for (int tx = 0; tx < m_layout.tilesX; tx++)
+            {
+                int x0 = tx * tileSize, x1 = std::min(x0 + tileSize, width);
+                int y0 = ty * tileSize, y1 = std::min(y0 + tileSize, height);
+                float n = (float)((x1 - x0) * (y1 - y0));
+                double sum = 0, sumSq = 0;
+                for (int y = y0; y < y1; y++)
+                {
+                    for (int x = x0; x < x1; x++)
+                    {
+                        int v = py[y*ls + x];
+                        sum += v;
+                        sumSq += v * v;
+                    }
+                }
+                TileStats &t = tiles[ty * m_layout.tilesX + tx];
+                t.r = regionSum(0, x0, y0, x1, y1) / n;
+                t.g = regionSum(1, x0, y0, x1, y1) / n;
+                t.b = regionSum(2, x0, y0, x1, y1) / n;
+                t.variance = (float)(sumSq / n - (sum / n) * (sum / n));
+            }
+        }
+        return true;
+    }
+
+    int TargetImage::width() const
+    { return m_width; }
+
+    int TargetImage::height() const
+    { return m_height; }
+
+    const uint8_t *TargetImage::plane(TargetPlane p, int level) const
+    {
+        return const_cast<TargetImage*>(this)->planeData(p, level);
+    }
+
+    int TargetImage::planeStride(TargetPlane p, int level) const
+    {
+        if (p == PlaneCb || p == PlaneCr)
+            return m_layout.chromaStride;
+        return m_layout.levelStride[level];
+    }
+
+    int TargetImage::levels() const
+    { return m_layout.levels; }
+
+    int TargetImage::levelWidth(int level) const
+    { return m_layout.levelWidth[level]; }
+
+    int TargetImage::levelHeight(int level) const
+    { return m_layout.levelHeight[level]; }
+
+    const uint32_t *TargetImage::integral(int channel) const
+    {
+        return const_cast<TargetImage*>(this)->integralData(channel);
+    }
+
+    uint32_t TargetImage::regionSum(int channel, int x0, int y0, int x1, int y1) const
+    {
+        const uint32_t *sat = integral(channel);
+        int is = m_width + 1;
+        return sat[y1*is + x1] - sat[y0*is + x1] - sat[y1*is + x0] + sat[y0*is + x0];
+    }
+
+    int TargetImage::tileSize() const
+    { return m_tileSize; }
+
+    int TargetImage::tilesX() const
+    { return m_layout.tilesX; }
+
+    int TargetImage::tilesY() const
+    { return m_layout.tilesY; }
+
+    const TileStats &TargetImage::tileStats(int tx, int ty) const
+    {
+        const TileStats *tiles = (const TileStats*)(m_arena + m_layout.tileOffset);
+        return tiles[ty * m_layout.tilesX + tx];
+    }
+
+    void TargetImage::setYccWeights(int lumaWeight, int chromaWeight)
+    {
+        m_lumaWeight = lumaWeight;
+        m_chromaWeight = chromaWeight;
+    }
+
+    uint32_t TargetImage::differenceRgb(const uint8_t *bgrx, int stride,
+                                        int x0, int y0, int x1, int y1) const
+    {
+        int ls = m_layout.levelStride[0];
+        const uint8_t *pr = plane(PlaneR), *pg = plane(PlaneG), *pb = plane(PlaneB);
+        uint32_t difference = 0;
+
+        x0 = std::max(0, x0);  x1 = std::min(m_width, x1);
+        y0 = std::max(0, y0);  y1 = std::min(m_height, y1);
+
+        for (int y = y0; y < y1; y++)
+        {
+            const uint8_t *row = bgrx + y * stride;
+            const uint8_t *tr = pr + y*ls, *tg = pg + y*ls, *tb = pb + y*ls;
+            for (int x = x0; x < x1; x++)
+            {
+                const uint8_t *c = row + x * 4;
+                int r = tr[x] - c[2];
+                int g = tg[x] - c[1];
+                int b = tb[x] - c[0];
+                difference += (uint32_t)std::sqrt(r*r + g*g + b*b);
+            }
+        }
+        return difference;
+    }
+
+    uint32_t TargetImage::differenceYcc(const uint8_t *bgrx, int stride,
+                                        int x0, int y0, int x1, int y1) const
+    {
+        const Layout &l = m_layout;
+        int cx0 = std::max(0, x0) / 2, cx1 = std::min(l.chromaWidth, (x1 + 1) / 2);
+        int cy0 = std::max(0, y0) / 2, cy1 = std::min(l.chromaHeight, (y1 + 1) / 2);
+        int ls = l.levelStride[0];
+        uint32_t luma = 0, chroma = 0;
+
+        for (int cy = cy0; cy < cy1; cy++)
+        {
+            int ya = 2*cy, yb = std::min(ya + 1, m_height - 1);
+            const uint8_t *rowA = bgrx + ya * stride;
+            const uint8_t *rowB = bgrx + yb * stride;
+            const uint8_t *lumaA = plane(PlaneY) + ya * ls;
+            const uint8_t *lumaB = plane(PlaneY) + yb * ls;
+            const uint8_t *cb = plane(PlaneCb) + cy * l.chromaStride;
+            const uint8_t *cr = plane(PlaneCr) + cy * l.chromaStride;
+
+            for (int cx = cx0; cx < cx1; cx++)
+            {
+                int xa = 2*cx, xb = std::min(xa + 1, m_width - 1);
+                const uint8_t *p00 = rowA + xa*4, *p01 = rowA + xb*4;
+                const uint8_t *p10 = rowB + xa*4, *p11 = rowB + xb*4;
+
+                // Duplicated edge pixels are counted once for luma
+                luma += std::abs(lumaOf(p00[2], p00[1], p00[0]) - lumaA[xa]);
+                if (xb != xa)
+                    luma += std::abs(lumaOf(p01[2], p01[1], p01[0]) - lumaA[xb]);
+                if (yb != ya)
+                {
+                    luma += std::abs(lumaOf(p10[2], p10[1], p10[0]) - lumaB[xa]);
+                    if (xb != xa)
+                        luma += std::abs(lumaOf(p11[2], p11[1], p11[0]) - lumaB[xb]);
+                }
+
+                int r = (p00[2] + p01[2] + p10[2] + p11[2] + 2) >> 2;
+                int g = (p00[1] + p01[1] + p10[1] + p11[1] + 2) >> 2;
+                int b = (p00[0] + p01[0] + p10[0] + p11[0] + 2) >> 2;
+                chroma += std::abs(cbOf(r, g, b) - cb[cx]);
+                chroma += std::abs(crOf(r, g, b) - cr[cx]);
+            }
+        }
+        return m_lumaWeight * luma + m_chromaWeight * chroma;
+    }
+
+    uint32_t TargetImage::difference(DiffMode mode, const uint8_t *bgrx, int stride,
+                                     int x0, int y0, int x1, int y1) const
+    {
+        if (mode == DiffYcc)
+            return differenceYcc(bgrx, stride, x0, y0, x1, y1);
+        return differenceRgb(bgrx, stride, x0, y0, x1, y1);
+    }
+
+    bool TargetImage::save(const char *filename) const
+    {
+        if (!m_arena)
+            return false;
+
+        FILE *outfp = fopen(filename, "wb");
+        if (outfp == NULL)
+            return false;
+
+        char header[headerSize];
+        FileHeader fh;
+        memset(header, 0, sizeof(header));
+        memcpy(fh.magic, fileMagic, sizeof(fh.magic));
+        fh.version = formatVersion;
+        fh.width = m_width;
+        fh.height = m_height;
+        fh.tileSize = m_tileSize;
+        fh.arenaSize = m_layout.size;
+        memcpy(header, &fh, sizeof(fh));
+
+        bool ok = (1 == fwrite(header, sizeof(header), 1, outfp) &&
+                   1 == fwrite(m_arena, m_layout.size, 1, outfp));
+        ok = (0 == fclose(outfp)) && ok;
+        return ok;
+    }
+
+    bool TargetImage::map(const char *filename)
+    {
+        release();
+
+        int fd = open(filename, O_RDONLY);
+        if (fd < 0)
+            return false;
+
+        struct stat st;
+        if (0 != fstat(fd, &st) || (size_t)st.st_size < headerSize)
+        {
+            close(fd);
+            return false;
+        }
+
+        void *mapping = mmap(0, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+        close(fd);                          // the mapping keeps the file open
+        if (mapping == MAP_FAILED)
+            return false;
+
+        FileHeader fh;
+        memcpy(&fh, mapping, sizeof(fh));
+        if (0 != memcmp(fh.magic, fileMagic, sizeof(fh.magic)) ||
+            fh.version != formatVersion || fh.width < 1 || fh.height < 1 || fh.tileSize < 1)
+        {
+            munmap(mapping, st.st_size);
+            return false;
+        }
+
+        computeLayout(fh.width, fh.height, fh.tileSize);
+        if (fh.arenaSize != m_layout.size ||
+            (size_t)st.st_size != headerSize + m_layout.size)
+        {
+            munmap(mapping, st.st_size);
+            memset(&m_layout, 0, sizeof(m_layout));
+            return false;
+        }
+
+        m_mapping = mapping;
+        m_mappingSize = st.st_size;
+        m_arena = (uint8_t*)mapping + headerSize;
+        m_width = fh.width;
+        m_height = fh.height;
+        m_tileSize = fh.tileSize;
+        return true;
+    }
+}
@@ -0,0 +1,95 @@
+/*
+ *  Evoimage-gl, a library and program to evolve images
+ *  Copyright (C) 2009 Brent Burton
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+#include <algorithm>
+#include "TileErrorMap.h"
+
+namespace ei
+{
+    TileErrorMap::TileErrorMap()
+        : m_width(0), m_height(0), m_tileSize(1)
+        , m_tilesX(0), m_tilesY(0), m_total(0)
+    { }
+
+    void TileErrorMap::reset(int width, int height, int tileSize)
+    {
+        m_width = width;
+        m_height = height;
+        m_tileSize = tileSize;
+        m_tilesX = (width + tileSize - 1) / tileSize;
+        m_tilesY = (height + tileSize - 1) / tileSize;
+        m_errors.assign(m_tilesX * m_tilesY, 0);
+        m_total = 0;
+    }
+
+    int TileErrorMap::tileSize() const
+    { return m_tileSize; }
+
+    int TileErrorMap::tilesX() const
+    { return m_tilesX; }
+
+    int TileErrorMap::tilesY() const
+    { return m_tilesY; }
+
+    DnaRect TileErrorMap::tileRect(int tx, int ty) const
+    {
+        return DnaRect(tx * m_tileSize, ty * m_tileSize,
+                       std::min((tx + 1) * m_tileSize, m_width),
+                       std::min((ty + 1) * m_tileSize, m_height));
+    }
+
+    bool TileErrorMap::tileSpan(DnaRect const &rect,
+                                int &tx0, int &ty0, int &tx1, int &ty1) const
+    {
+        DnaRect r(std::max(rect.x0, 0), std::max(rect.y0, 0),
+                  std::min(rect.x1, m_width), std::min(rect.y1, m_height));
+        if (r.empty())
+            return false;
+
+        tx0 = r.x0 / m_tileSize;
+        ty0 = r.y0 / m_tileSize;
+        tx1 = (r.x1 + m_tileSize - 1) / m_tileSize;
+        ty1 = (r.y1 + m_tileSize - 1) / m_tileSize;
+        return true;
+    }
+
+    uint32_t TileErrorMap::error(int tx, int ty) const
+    { return m_errors[ty * m_tilesX + tx]; }
+
+    void TileErrorMap::setError(int tx, int ty, uint32_t error)
+    {
+        uint32_t &e = m_errors[ty * m_tilesX + tx];
+        m_total = m_total - e + error;
+        e = error;
+    }
+
+    uint32_t TileErrorMap::total() const
+    { return m_total; }
+
+    void TileErrorMap::worstTile(int &tx, int &ty) const
+    {
+        int worst = 0;
+        for (int i = 1; i < (int)m_errors.size(); i++)
+        {
+            if (m_errors[i] > m_errors[worst])
+                worst = i;
+        }
+        tx = m_tilesX ? worst % m_tilesX : 0;
+        ty = m_tilesX ? worst / m_tilesX : 0;
+    }
+}
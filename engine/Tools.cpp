@@ -17,6 +17,7 @@
  *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
  */
 #include <stdlib.h>
+#include <algorithm>
 #include "Tools.h"
 
 namespace ei
@@ -26,9 +27,33 @@ namespace ei
     const int Tools::maxHeight   = 200;
     const int Tools::maxPolygons = 250;
 
+    static thread_local bool     t_seeded = false;
+    static thread_local uint64_t t_state;
+
+    void Tools::seedThread(uint64_t seed)
+    {
+        // splitmix64 spreads nearby seeds over the whole state space
+        seed += 0x9e3779b97f4a7c15ULL;
+        seed = (seed ^ (seed >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        seed = (seed ^ (seed >> 27)) * 0x94d049bb133111ebULL;
+        t_state = (seed ^ (seed >> 31)) | 1;
+        t_seeded = true;
+    }
+
     int Tools::getRandomNumber(int min, int max)
     {
-        return min + (rand() % (max-min+1));
+        int r;
+        if (t_seeded)
+        {
+            // xorshift64*, cut to 31 bits like rand()
+            t_state ^= t_state >> 12;
+            t_state ^= t_state << 25;
+            t_state ^= t_state >> 27;
+            r = (int)((t_state * 0x2545f4914f6cdd1dULL) >> 33);
+        }
+        else
+            r = rand();
+        return min + (r % (max-min+1));
     }
 
     bool Tools::willMutate(int mutationRate)
@@ -36,4 +61,40 @@ namespace ei
         // i.e., a (1 in mutationRate) chance
         return getRandomNumber(0, mutationRate) == 1;
     }
+
+    PositionSampler::~PositionSampler()
+    { }
+
+    static thread_local PositionSampler *s_positionSampler = 0;
+    static thread_local int s_bounds[4] = {0, 0, Tools::maxWidth, Tools::maxHeight};
+
+    void Tools::setPositionSampler(PositionSampler *sampler)
+    {
+        s_positionSampler = sampler;
+    }
+
+    void Tools::getRandomPosition(int &x, int &y)
+    {
+        if (s_positionSampler)
+        {
+            s_positionSampler->sample(x, y);
+            return;
+        }
+        x = getRandomNumber(s_bounds[0], s_bounds[2]);
+        y = getRandomNumber(s_bounds[1], s_bounds[3]);
+    }
+
+    void Tools::setBounds(int x0, int y0, int x1, int y1)
+    {
+        s_bounds[0] = x0;
+        s_bounds[1] = y0;
+        s_bounds[2] = x1;
+        s_bounds[3] = y1;
+    }
+
+    void Tools::clampPosition(int &x, int &y)
+    {
+        x = std::min(std::max(s_bounds[0], x), s_bounds[2]);
+        y = std::min(std::max(s_bounds[1], y), s_bounds[3]);
+    }
 }
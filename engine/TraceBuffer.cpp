@@ -0,0 +1,151 @@
+/*
+ *  Evoimage-gl, a library and program to evolve images
+ *  Copyright (C) 2009 Brent Burton
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+#include <stdio.h>
+#include <unistd.h>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "TraceBuffer.h"
+
+namespace ei
+{
+    bool                           TraceBuffer::s_enabled = false;
+    size_t                         TraceBuffer::s_capacity = 0;
+    TraceBuffer::Clock::time_point TraceBuffer::s_origin;
+
+    namespace
+    {
+        // Rings grow a chunk at a time as events arrive, up to the capacity,
+        // so a thread that records little costs little
+        const size_t chunkEvents = 4096;
+
+        struct ThreadRing
+        {
+            int                                            tid;
+            std::string                                    name;
+            std::vector<std::unique_ptr<TraceBuffer::Event[]> > chunks;
+            size_t                                         capacity;
+            uint64_t                                       recorded; // ever, including overwritten
+
+            TraceBuffer::Event &at(uint64_t i)
+            {
+                size_t slot = i % capacity;
+                return chunks[slot / chunkEvents][slot % chunkEvents];
+            }
+        };
+
+        std::mutex                s_ringsMutex;
+        std::vector<ThreadRing *> s_rings;      // kept past thread exit, for write()
+        thread_local ThreadRing  *t_ring = 0;
+
+        ThreadRing *threadRing(size_t capacity)
+        {
+            if (!t_ring)
+            {
+                std::lock_guard<std::mutex> lock(s_ringsMutex);
+                t_ring = new ThreadRing;
+                t_ring->tid = s_rings.size() + 1;
+                t_ring->capacity = capacity;
+                t_ring->recorded = 0;
+                s_rings.push_back(t_ring);
+            }
+            return t_ring;
+        }
+    }
+
+    void TraceBuffer::start(size_t eventsPerThread)
+    {
+        s_capacity = eventsPerThread > 0 ? eventsPerThread : 1;
+        s_origin = Clock::now();
+        s_enabled = true;
+    }
+
+    void TraceBuffer::setThreadName(const char *name)
+    {
+        if (s_enabled)
+            threadRing(s_capacity)->name = name;
+    }
+
+    void TraceBuffer::record(const char *name, Clock::time_point start, Clock::time_point end)
+    {
+        ThreadRing *ring = threadRing(s_capacity);
+        if (ring->recorded < ring->capacity && ring->recorded == ring->chunks.size() * chunkEvents)
+            ring->chunks.emplace_back(new Event[chunkEvents]);
+        Event &e = ring->at(ring->recorded);
+        e.name = name;
+        e.start = std::chrono::duration_cast<std::chrono::nanoseconds>(start - s_origin).count();
+        e.duration = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+        ring->recorded++;
+    }
+
+    void TraceBuffer::discard()
+    {
+        std::lock_guard<std::mutex> lock(s_ringsMutex);
+        for (size_t r = 0; r < s_rings.size(); r++)
+        {
+            s_rings[r]->chunks.clear();
+            s_rings[r]->recorded = 0;
+        }
+    }
+
+    bool TraceBuffer::write(const char *filename)
+    {
+        s_enabled = false;
+
+        FILE *f = fopen(filename, "w");
+        if (!f)
+            return false;
+
+        std::lock_guard<std::mutex> lock(s_ringsMutex);
+        int pid = getpid();
+        uint64_t dropped = 0;
+        const char *sep = "";
+
+        fprintf(f, "{\"traceEvents\":[\n");
+        for (size_t r = 0; r < s_rings.size(); r++)
+        {
+            ThreadRing *ring = s_rings[r];
+            if (ring->name.length())
+            {
+                fprintf(f, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":%d,"
+                        "\"args\":{\"name\":\"%s\"}}", sep, pid, ring->tid, ring->name.c_str());
+                sep = ",\n";
+            }
+
+            // Oldest first: once the ring has wrapped, it starts at the write position
+            size_t size = ring->capacity;
+            uint64_t count = ring->recorded < size ? ring->recorded : size;
+            uint64_t first = ring->recorded - count;
+            dropped += first;
+            for (uint64_t i = first; i < ring->recorded; i++)
+            {
+                Event const &e = ring->at(i);
+                fprintf(f, "%s{\"name\":\"%s\",\"ph\":\"X\",\"pid\":%d,\"tid\":%d,"
+                        "\"ts\":%.3f,\"dur\":%.3f}", sep, e.name, pid, ring->tid,
+                        e.start / 1000.0, e.duration / 1000.0);
+                sep = ",\n";
+            }
+        }
+        fprintf(f, "\n],\"displayTimeUnit\":\"ms\",\"otherData\":{\"dropped\":%llu}}\n",
+                (unsigned long long)dropped);
+
+        return 0 == fclose(f);
+    }
+}
@@ -0,0 +1,94 @@
+/*
+ *  Evoimage-gl, a library and program to evolve images
+ *  Copyright (C) 2009 Brent Burton
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+/*
+ * AcceptancePolicy
+ * Decides whether the best child of a generation replaces its parent.
+ * The classic rule is greedy: only a strictly better child. Annealing
+ * and threshold accepting also take worse children, less and less
+ * often as the run goes on, to walk off plateaus.
+ *
+ * Temperatures and thresholds are fractions of the parent's difference,
+ * so one setting suits targets of any size or difficulty. They fall
+ * from start to end over the generation limit along a schedule.
+ */
+#pragma once
+
+#include <cstdint>
+
+namespace ei
+{
+    enum CoolingSchedule
+    {
+        CoolExponential,                    // start * (end/start)^progress
+        CoolLinear                          // start + (end-start) * progress
+    };
+
+    class AcceptancePolicy
+    {
+      public:
+        virtual ~AcceptancePolicy();
+
+        // Whether a child scoring candidate replaces a parent scoring
+        // current, at generation of limit
+        virtual bool accept(uint32_t current, uint32_t candidate,
+                            int generation, int limit) = 0;
+
+        // True if accept() never takes a worse child, so the parent is
+        // always the best drawing seen
+        virtual bool monotone() const;
+    };
+
+    class GreedyAcceptance : public AcceptancePolicy
+    {
+      public:
+        bool accept(uint32_t current, uint32_t candidate, int generation, int limit);
+        bool monotone() const;
+    };
+
+    class ScheduledAcceptance : public AcceptancePolicy
+    {
+      protected:
+        double          m_start;
+        double          m_end;
+        CoolingSchedule m_schedule;
+
+      public:
+        ScheduledAcceptance(double start, double end, CoolingSchedule schedule);
+
+        // The temperature or threshold at generation of limit
+        double level(int generation, int limit) const;
+    };
+
+    // Metropolis rule: a child worse by delta is taken with probability
+    // exp(-delta / (T * current))
+    class AnnealingAcceptance : public ScheduledAcceptance
+    {
+      public:
+        AnnealingAcceptance(double start, double end, CoolingSchedule schedule);
+        bool accept(uint32_t current, uint32_t candidate, int generation, int limit);
+    };
+
+    // Threshold accepting: a child worse by no more than T * current is taken
+    class ThresholdAcceptance : public ScheduledAcceptance
+    {
+      public:
+        ThresholdAcceptance(double start, double end, CoolingSchedule schedule);
+        bool accept(uint32_t current, uint32_t candidate, int generation, int limit);
+    };
+}
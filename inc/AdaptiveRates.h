@@ -0,0 +1,66 @@
+/*
+ *  Evoimage-gl, a library and program to evolve images
+ *  Copyright (C) 2009 Brent Burton
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+/*
+ * AdaptiveRates
+ * Re-weights the active mutation rates while evolving. Each accepted
+ * child counts a success for every operator it applied; at every
+ * update() each operator's success rate per application is compared
+ * against the mean over all operators, and its rate is moved toward
+ * more (or fewer) applications, staying within [base/bound, base*bound]
+ * of the rate active at construction.
+ *
+ * The counts are kept over roughly an operator's last `horizon`
+ * applications rather than over update windows, so rare operators are
+ * scored once they have minTrials applications however often update()
+ * is called.
+ */
+#pragma once
+
+#include "MutationOp.h"
+
+namespace ei
+{
+    class DnaDrawing;
+
+    class AdaptiveRates
+    {
+      protected:
+        double   m_bound;
+        unsigned m_minTrials;               // applications needed before an op is re-weighted
+        unsigned m_horizon;                 // applications the counts are kept over
+        int      m_base[MutationOpCount];
+        double   m_rate[MutationOpCount];   // unrounded; the active rates are these rounded
+        double   m_trials[MutationOpCount]; // applications, at most m_horizon after update()
+        double   m_credit[MutationOpCount]; // successes, scaled down with them
+
+      public:
+        AdaptiveRates(double bound, unsigned minTrials = 20, unsigned horizon = 400);
+
+        // Account for one evaluated child, and whether it replaced its parent
+        void record(DnaDrawing &child, bool accepted);
+
+        // Re-weight Settings::active*MutationRate and start a new window
+        void update();
+
+        int baseRate(MutationOp op) const;
+
+        // Whether op has had enough applications to be re-weighted
+        bool scored(MutationOp op) const;
+    };
+}
@@ -0,0 +1,48 @@
+/*
+ *  Evoimage-gl, a library and program to evolve images
+ *  Copyright (C) 2009 Brent Burton
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+/*
+ * AliasTable
+ * Walker/Vose alias method: after an O(n) build, draws index i with
+ * probability weight[i]/sum(weights) in constant time.
+ */
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+namespace ei
+{
+    class AliasTable
+    {
+      protected:
+        std::vector<uint32_t> m_threshold;  // keep i if a 16-bit draw is below this
+        std::vector<int>      m_alias;
+
+      public:
+        static const uint32_t scale = 65536;
+
+        AliasTable();
+
+        // Returns false (and leaves the table empty) if no weight is positive
+        bool build(std::vector<double> const &weights);
+
+        bool empty() const;
+        int sample() const;
+    };
+}
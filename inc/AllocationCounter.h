@@ -0,0 +1,43 @@
+/*
+ *  Evoimage-gl, a library and program to evolve images
+ *  Copyright (C) 2009 Brent Burton
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+/*
+ * AllocationCounter
+ * Counts heap allocations for the profile. Linking this in replaces the
+ * whole operator new/delete family with versions that allocate with
+ * malloc() and free with free(); counting costs nothing until enable().
+ * Each thread counts in its own counter, so counting is uncontended,
+ * and count() sums them. Cairo's own buffers come from malloc and are
+ * not included.
+ */
+#pragma once
+
+#include <cstdint>
+
+namespace ei
+{
+    namespace AllocationCounter
+    {
+        // Start counting. Call before starting the threads to be counted.
+        void enable();
+        bool enabled();
+
+        // operator new calls since enable(), over all threads
+        uint64_t count();
+    }
+}
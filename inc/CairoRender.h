@@ -0,0 +1,46 @@
+/*
+ *  Evoimage-gl, a library and program to evolve images
+ *  Copyright (C) 2009 Brent Burton
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+/*
+ * CairoRender
+ * Renders drawings with Cairo into RGB24 image surfaces. This is the one
+ * rendering path: evoimagecairo evolves with it, and evobench times it.
+ */
+#pragma once
+
+#include <cairo.h>
+
+namespace ei
+{
+    class DnaDrawing;
+    class DnaRect;
+
+    namespace CairoRender
+    {
+        // Fill the drawing's polygons that can touch clip
+        void drawPolygons(cairo_t *ctx, DnaDrawing *d, DnaRect const &clip);
+
+        // The whole drawing on black, scaled to width x height. Returns 0
+        // if the surface cannot be created.
+        cairo_surface_t *render(DnaDrawing *d, int width, int height);
+
+        // A drawing that differs from the one rendered in base only inside
+        // clip: a copy of base with just the clipped area redrawn
+        cairo_surface_t *renderOver(DnaDrawing *d, cairo_surface_t *base, DnaRect const &clip);
+    }
+}
@@ -0,0 +1,60 @@
+/*
+ *  Evoimage-gl, a library and program to evolve images
+ *  Copyright (C) 2009 Brent Burton
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+/*
+ * ComplexityCost
+ * What a drawing costs to render, as a penalty on its difference: a
+ * price per polygon and per vertex, and optionally a hard budget on the
+ * area its polygons fill, overdraw included. A drawing over the budget
+ * scores worse than any within it, and worse the further over it is.
+ */
+#pragma once
+
+#include <cstdint>
+
+namespace ei
+{
+    class DnaDrawing;
+    class DnaPolygon;
+
+    class ComplexityCost
+    {
+      public:
+        static const uint32_t overBudgetScore = 1u << 31; // least score over the budget
+
+      protected:
+        uint32_t m_polygonCost;
+        uint32_t m_vertexCost;
+        double   m_areaBudget;              // in pixels; 0 = none
+
+      public:
+        ComplexityCost(uint32_t polygonCost = 0, uint32_t vertexCost = 0, double areaBudget = 0);
+
+        bool enabled() const;
+
+        // Pixels a polygon fills (the shoelace area, so only an estimate
+        // for self-intersecting ones), and all of a drawing's summed
+        static double area(DnaPolygon &polygon);
+        static double area(DnaDrawing &drawing);
+
+        bool overBudget(DnaDrawing &drawing) const;
+
+        // difference plus the penalty of drawing
+        uint32_t score(DnaDrawing &drawing, uint32_t difference) const;
+    };
+}
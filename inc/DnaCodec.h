@@ -0,0 +1,56 @@
+/*
+ *  Evoimage-gl, a library and program to evolve images
+ *  Copyright (C) 2009 Brent Burton
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+/*
+ * DnaCodec
+ * A compact binary form of a DnaDrawing, for handing drawings between
+ * processes. Little endian, no padding:
+ *
+ *   u16 polygon count, then per polygon:
+ *     u8 point count, u8 r, g, b, a, then per point u16 x, u16 y
+ *
+ * decode() accepts only what encode() can produce from a drawing on the
+ * canvas: at least 3 points per polygon, coordinates within
+ * [0,maxWidth] x [0,maxHeight], and no bytes left over.
+ *
+ * A 50 polygon drawing of 6 point polygons takes about 1.5 KB.
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace ei
+{
+    class DnaDrawing;
+
+    namespace DnaCodec
+    {
+        // Bytes needed for a drawing of at most this many polygons and points
+        size_t maxSize(int polygons, int pointsPerPolygon);
+
+        size_t encodedSize(DnaDrawing &drawing);
+
+        // Encode into buffer; returns the bytes written, or 0 if they
+        // would not fit in capacity or a coordinate is outside u16.
+        size_t encode(DnaDrawing &drawing, uint8_t *buffer, size_t capacity);
+
+        // A new drawing, or 0 if the bytes are not a well formed encoding
+        DnaDrawing *decode(const uint8_t *buffer, size_t size);
+    }
+}
@@ -19,6 +19,7 @@
 #pragma once
 
 #include "DnaPolygon.h"
+#include "MutationOp.h"
 
 namespace ei
 {
@@ -27,6 +28,9 @@ namespace ei
       protected:
         DnaPolygonList m_polygons;
         bool            m_dirty;
+        unsigned        m_changes;          // count of setDirty() calls
+        DnaRect         m_dirtyRect;        // area changed since clone()
+        unsigned short  m_opCounts[MutationOpCount]; // operators applied since clone()
 
       public:
         DnaDrawing();
@@ -39,16 +43,35 @@ namespace ei
 
         bool dirty();
         void setDirty();
+        void setDirty(MutationOp op);       // also counts op as applied
+
+        // How many times op changed this drawing since clone()
+        unsigned opCount(MutationOp op);
+
+        // Pixels that may differ from the drawing this one was cloned
+        // from. Empty if no mutation changed anything. touch() adds a
+        // polygon's bounds and marks the polygon changed().
+        DnaRect const &dirtyRect();
+        void touch(DnaPolygon &polygon);
 
         int pointCount();
 
         DnaDrawing* clone();
 
+        // Make this drawing a clone() of other without allocating a
+        // new one (or drawing random numbers for it)
+        void copyFrom(DnaDrawing const &other);
+
         // mutation methods
         void mutate();
         void movePolygon();
         void removePolygon();
         void addPolygon();
+
+        // Two-point crossover: replace a random range of this drawing's
+        // polygons with those at the same positions in other. The
+        // replaced and replacing polygons are touched.
+        void crossover(DnaDrawing &other);
     };
 
 }
@@ -18,9 +18,11 @@
  */
 #pragma once
 
+#include <cstddef>
 #include <vector>
 #include "DnaPoint.h"
 #include "DnaBrush.h"
+#include "DnaRect.h"
 
 namespace ei
 {
@@ -31,6 +33,7 @@ namespace ei
       protected:
         DnaPointList m_points;
         DnaBrush     m_brush;
+        bool         m_changed;             // mutated since its drawing was cloned
 
       public:
         DnaPolygon();
@@ -48,6 +51,12 @@ namespace ei
 
         size_t pointCount();
 
+        // Pixels the polygon can touch when filled, antialiasing included
+        DnaRect bounds();
+
+        bool changed();
+        void setChanged(bool changed);
+
         void mutate(DnaDrawing &drawing);
         void addPoint(DnaDrawing &drawing);
         void removePoint(DnaDrawing &drawing);
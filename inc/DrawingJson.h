@@ -0,0 +1,44 @@
+/*
+ *  Evoimage-gl, a library and program to evolve images
+ *  Copyright (C) 2009 Brent Burton
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+/*
+ * DrawingJson
+ * The JSON form of a drawing that evoimagecairo writes and evorender
+ * reads:
+ *   - a drawing contains an array of polygons
+ *   - a polygon has a color, and an array of points
+ *   - a color is R,G,B,A values as doubles [0,1]
+ *   - a point is X,Y coordinates as doubles [0,1]
+ */
+#pragma once
+
+#include <string>
+#include <json/json.h>
+
+namespace ei
+{
+    class DnaDrawing;
+
+    namespace DrawingJson
+    {
+        Json::Value toJson(DnaDrawing *drawing);
+
+        // Write the drawing to filename, indented. False if it cannot be opened.
+        bool save(DnaDrawing *drawing, std::string const &filename);
+    }
+}
@@ -0,0 +1,50 @@
+/*
+ *  Evoimage-gl, a library and program to evolve images
+ *  Copyright (C) 2009 Brent Burton
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+/*
+ * GuidedSampler
+ * Places new polygons and large point moves where the parent is still
+ * wrong: a tile is drawn in proportion to its residual error, then a
+ * uniform position inside it. Some share of draws stays uniform so no
+ * region is ever abandoned.
+ */
+#pragma once
+
+#include "Tools.h"
+#include "AliasTable.h"
+#include "TileErrorMap.h"
+
+namespace ei
+{
+    class GuidedSampler : public PositionSampler
+    {
+      protected:
+        AliasTable   m_table;
+        TileErrorMap m_tiles;               // geometry only; errors live in m_table
+        int          m_percent;             // share of guided draws, 0..100
+
+      public:
+        GuidedSampler(int percent);
+
+        // Rebuild from the current parent's residual. Cheap (one pass over
+        // the tiles), but only needed when the parent changes.
+        void update(TileErrorMap const &errors);
+
+        virtual void sample(int &x, int &y);
+    };
+}
@@ -0,0 +1,49 @@
+/*
+ *  Evoimage-gl, a library and program to evolve images
+ *  Copyright (C) 2009 Brent Burton
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+/*
+ * Initializer
+ * First drawings seeded from the target rather than at random, so that
+ * evolution starts with the average colors in place:
+ *
+ *   grid    a grid of quads over the area, each the mean color of its cell
+ *   kmeans  clusters of position and color (SLIC style) on a coarse
+ *           pyramid level, each drawn as its convex hull in its mean
+ *           color, largest first
+ *
+ * Polygons are opaque, and both stay within the active polygon and
+ * point limits.
+ */
+#pragma once
+
+namespace ei
+{
+    class DnaDrawing;
+    class DnaRect;
+    class TargetImage;
+
+    namespace Initializer
+    {
+        // About polygons cells of the area, close to square
+        DnaDrawing *grid(TargetImage const &target, DnaRect const &area, int polygons);
+
+        // polygons clusters of the area, after iterations rounds of k-means
+        DnaDrawing *kmeans(TargetImage const &target, DnaRect const &area, int polygons,
+                           int iterations = 10);
+    }
+}
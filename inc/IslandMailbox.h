@@ -0,0 +1,91 @@
+/*
+ *  Evoimage-gl, a library and program to evolve images
+ *  Copyright (C) 2009 Brent Burton
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+/*
+ * IslandMailbox
+ * Shared memory through which islands -- threads, or worker processes
+ * forked after create() -- show each other their progress and trade
+ * drawings. Each island owns one slot and is its only writer; anyone
+ * may read any slot.
+ *
+ * The scalar fields are plain atomics. The drawing is held in DnaCodec
+ * form behind a sequence counter that is odd while it is being written
+ * (as in LiveStats), so readers never block the owner.
+ */
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include "MutationStats.h"
+
+namespace ei
+{
+    class DnaDrawing;
+
+    struct IslandSlot
+    {
+        std::atomic<uint32_t> sequence;     // odd while the drawing is written
+        std::atomic<uint32_t> posted;       // drawings posted so far
+        std::atomic<uint32_t> difference;   // of the island's parent
+        std::atomic<uint32_t> fitness;      // ...and the parent's fitness, which ranks islands
+        std::atomic<int32_t>  generation;
+        std::atomic<int32_t>  lastImprovement;
+        std::atomic<int32_t>  polygons;
+        std::atomic<int32_t>  points;
+        std::atomic<uint32_t> done;         // final drawing and stats posted
+        MutationStats         stats;        // valid once done
+        uint32_t              size;         // bytes of the drawing that follows
+    };
+
+    class IslandMailbox
+    {
+      protected:
+        uint8_t *m_block;
+        size_t   m_blockSize;
+        size_t   m_slotSize;
+        size_t   m_capacity;                // drawing bytes per slot
+        int      m_slots;
+
+        uint8_t *drawingData(int island);
+
+      private:
+        IslandMailbox(IslandMailbox const &);
+        IslandMailbox &operator=(IslandMailbox const &);
+
+      public:
+        IslandMailbox();
+        ~IslandMailbox();
+
+        // Map zeroed, shared, anonymous memory for this many islands with
+        // room for drawings of up to polygons x pointsPerPolygon.
+        bool create(int islands, int polygons, int pointsPerPolygon);
+        void close();
+
+        int islands() const;
+        IslandSlot &slot(int island);
+
+        // Publish a copy of the island's drawing. Only its owner may call this.
+        bool post(int island, DnaDrawing &drawing);
+
+        // A copy of the drawing an island last posted, or 0 if it has not
+        // posted one since serial (pass 0 for any) or is mid-write. serial
+        // is updated to the posting returned.
+        DnaDrawing *take(int island, uint32_t &serial);
+    };
+}
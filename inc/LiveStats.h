@@ -0,0 +1,101 @@
+/*
+ *  Evoimage-gl, a library and program to evolve images
+ *  Copyright (C) 2009 Brent Burton
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+/*
+ * LiveStats
+ * Publishes the state of a run in a small memory-mapped file (put it on
+ * /dev/shm for a pure shared-memory page) for monitors to poll. The
+ * writer never blocks or makes a system call to publish: the block is
+ * guarded by a sequence counter that is odd while an update is being
+ * written, and readers retry until they copy an even, unchanged one.
+ *
+ * The file holds a LiveStatsBlock in native byte order. Readers in
+ * other languages check magic and version, then follow the same rule:
+ * read sequence, copy data, read sequence again.
+ */
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include "PhaseProfiler.h"
+
+namespace ei
+{
+    enum LiveState
+    {
+        LiveStarting,
+        LiveRunning,
+        LiveFinished
+    };
+
+    struct LiveStatsData
+    {
+        uint64_t generation;
+        uint64_t generationLimit;
+        uint64_t difference;                // of the current best drawing
+        uint64_t polygons;
+        uint64_t points;
+        uint64_t state;                     // LiveState
+        uint64_t updated;                   // wall clock, ms since the epoch
+        uint64_t lastImprovement;           // generation the best last improved
+        double   gensPerSecond;             // over the last second or so
+        double   childrenPerSecond;
+        uint64_t phaseNs[PhaseCount];       // cumulative, when profiling
+    };
+
+    struct LiveStatsBlock
+    {
+        char                  magic[8];     // "EISTATS"
+        uint32_t              version;
+        uint32_t              pid;
+        std::atomic<uint32_t> sequence;
+        uint32_t              reserved;
+        LiveStatsData         data;
+    };
+
+    class LiveStats
+    {
+      public:
+        static const uint32_t version;
+
+      protected:
+        LiveStatsBlock *m_block;
+        int             m_fd;
+        LiveStatsData   m_data;             // staged, copied out by publish()
+
+      private:
+        LiveStats(LiveStats const &);
+        LiveStats &operator=(LiveStats const &);
+
+      public:
+        LiveStats();
+        ~LiveStats();
+
+        // Create (or replace) the stats file and map it
+        bool open(const char *filename);
+        void close();
+        bool isOpen() const;
+
+        // Fill in data(), then publish() it
+        LiveStatsData &data();
+        void publish();
+
+        // Copy a consistent snapshot out of a stats file another process writes
+        static bool read(const char *filename, LiveStatsData &data, uint32_t &pid);
+    };
+}
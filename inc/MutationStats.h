@@ -0,0 +1,65 @@
+/*
+ *  Evoimage-gl, a library and program to evolve images
+ *  Copyright (C) 2009 Brent Burton
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+/*
+ * MutationStats
+ * Per-operator telemetry: how often each mutation operator was applied,
+ * how many of the children it appeared in replaced their parent, and
+ * the difference improvement those children achieved. A child applying
+ * several operators shares its improvement with each of them in full.
+ */
+#pragma once
+
+#include <cstdint>
+#include "MutationOp.h"
+
+namespace ei
+{
+    class DnaDrawing;
+
+    struct MutationOpStats
+    {
+        uint64_t fired;                     // applications of the operator
+        uint64_t children;                  // children it was applied to
+        uint64_t accepted;                  // ...of which replaced the parent
+        uint64_t improvement;               // difference removed by those
+    };
+
+    class MutationStats
+    {
+      protected:
+        MutationOpStats m_ops[MutationOpCount];
+        uint64_t        m_children;
+        uint64_t        m_accepted;
+
+      public:
+        MutationStats();
+        void reset();
+
+        // Fold in the counts of another set, e.g. another thread's
+        void add(MutationStats const &other);
+
+        // Account for one evaluated child. improvement is the drop in
+        // difference from its parent, and is ignored unless accepted.
+        void record(DnaDrawing &child, bool accepted, uint32_t improvement);
+
+        MutationOpStats const &op(MutationOp op) const;
+        uint64_t children() const;
+        uint64_t accepted() const;
+    };
+}
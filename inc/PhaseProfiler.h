@@ -0,0 +1,128 @@
+/*
+ *  Evoimage-gl, a library and program to evolve images
+ *  Copyright (C) 2009 Brent Burton
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+/*
+ * PhaseProfiler
+ * Low-overhead accounting of where a run spends its time. Code wraps
+ * each phase in a PhaseTimer; with a null profiler the timer does
+ * nothing but test a pointer. Timers may nest, and each phase is
+ * charged only its own time, so the phases never add up to more than
+ * the wall time. Totals are kept both cumulatively and for the current
+ * interval, which endInterval() closes. Not thread safe: time phases on
+ * the thread that owns the profiler.
+ */
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+
+namespace ei
+{
+    class PhaseTimer;
+
+    enum ProfilePhase
+    {
+        PhaseClone,
+        PhaseMutate,
+        PhaseRender,
+        PhaseDiff,
+        PhaseSelect,
+        PhaseSnapshot,                      // image and JSON output
+        PhaseCount
+    };
+
+    const char *profilePhaseName(ProfilePhase phase);
+
+    class PhaseProfiler
+    {
+      public:
+        typedef std::chrono::steady_clock Clock;
+
+        struct Totals
+        {
+            double   seconds;               // wall time covered
+            uint64_t ns[PhaseCount];
+            uint64_t calls[PhaseCount];
+            uint64_t generations;
+            uint64_t children;
+            uint64_t accepted;
+            uint64_t allocations;
+        };
+
+      protected:
+        friend class PhaseTimer;
+        PhaseTimer *m_active;               // innermost running timer
+        Clock::time_point m_start;
+        Clock::time_point m_intervalStart;
+        uint64_t m_allocationBase;          // allocation count when the interval began
+        Totals   m_current;                 // interval being accumulated
+        Totals   m_interval;                // last closed interval
+        Totals   m_total;
+
+      public:
+        PhaseProfiler();
+
+        void add(ProfilePhase phase, Clock::duration elapsed);
+        void countGeneration(unsigned children, bool accepted);
+
+        // Close the current interval. allocations is the process' running
+        // allocation count; the profiler keeps the differences.
+        void endInterval(uint64_t allocations);
+
+        // The last closed interval, and everything up to its end
+        Totals const &interval() const;
+        Totals const &total() const;
+
+        // The interval still open (seconds and allocations not yet set)
+        Totals const &current() const;
+    };
+
+    class PhaseTimer
+    {
+      protected:
+        PhaseProfiler *m_profiler;
+        PhaseTimer    *m_parent;
+        ProfilePhase   m_phase;
+        PhaseProfiler::Clock::time_point m_start;
+        PhaseProfiler::Clock::duration   m_nested; // spent in timers inside this one
+
+      public:
+        PhaseTimer(PhaseProfiler *profiler, ProfilePhase phase)
+            : m_profiler(profiler), m_parent(0), m_phase(phase), m_nested(0)
+        {
+            if (m_profiler)
+            {
+                m_parent = m_profiler->m_active;
+                m_profiler->m_active = this;
+                m_start = PhaseProfiler::Clock::now();
+            }
+        }
+
+        ~PhaseTimer()
+        {
+            if (m_profiler)
+            {
+                PhaseProfiler::Clock::duration elapsed = PhaseProfiler::Clock::now() - m_start;
+                m_profiler->add(m_phase, elapsed - m_nested);
+                if (m_parent)
+                    m_parent->m_nested += elapsed;
+                m_profiler->m_active = m_parent;
+            }
+        }
+    };
+}
@@ -0,0 +1,52 @@
+/*
+ *  Evoimage-gl, a library and program to evolve images
+ *  Copyright (C) 2009 Brent Burton
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+/*
+ * PlateauDetector
+ * Watches the best difference of a lineage, one value per generation,
+ * and reports a plateau once the last window generations together
+ * improved it by less than a given fraction.
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace ei
+{
+    class PlateauDetector
+    {
+      protected:
+        std::vector<uint32_t> m_history;    // ring of the last window differences
+        size_t                m_next;
+        size_t                m_count;
+        double                m_minGain;
+
+      public:
+        PlateauDetector(int window, double minGain);
+
+        // Forget the history, e.g. after a restart
+        void reset();
+
+        // Record this generation's difference. True if the window is
+        // full and its oldest value is less than minGain above this one,
+        // relatively.
+        bool update(uint32_t difference);
+    };
+}
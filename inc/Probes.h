@@ -0,0 +1,50 @@
+/*
+ *  Evoimage-gl, a library and program to evolve images
+ *  Copyright (C) 2009 Brent Burton
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+/*
+ * Probes
+ * Static USDT probes under the "evoimage" provider, for perf, bpftrace
+ * and friends (e.g. bpftrace -e 'usdt:./evoimagecairo:evoimage:child_accept
+ * { @[arg0] = count(); }'). Each probe is a nop in the code until a
+ * tracer attaches. Without sys/sdt.h (EI_HAVE_SDT unset by the build)
+ * the probes compile away entirely.
+ *
+ * Probes and their arguments:
+ *   generation_start  (generation)
+ *   generation_end    (generation, difference)
+ *   child_accept      (generation, child, difference, parent difference)
+ *   child_reject      (generation, child, difference, parent difference)
+ *   snapshot_write    (image index)
+ *   mutation          (MutationOp)
+ */
+#pragma once
+
+#ifdef EI_HAVE_SDT
+#include <sys/sdt.h>
+
+#define EI_PROBE1(name, a)          DTRACE_PROBE1(evoimage, name, a)
+#define EI_PROBE2(name, a, b)       DTRACE_PROBE2(evoimage, name, a, b)
+#define EI_PROBE4(name, a, b, c, d) DTRACE_PROBE4(evoimage, name, a, b, c, d)
+
+#else
+
+#define EI_PROBE1(name, a)          do { } while (0)
+#define EI_PROBE2(name, a, b)       do { } while (0)
+#define EI_PROBE4(name, a, b, c, d) do { } while (0)
+
+#endif
@@ -18,6 +18,8 @@
  */
 #pragma once
 
+#include "MutationOp.h"
+
 namespace ei
 {
     class Settings
@@ -52,6 +54,9 @@ namespace ei
         static int activeRemovePointMutationRate;
         static int activeRemovePolygonMutationRate;
 
+        // The active rate driving op, for code that tunes rates at run time
+        static int &activeMutationRate(MutationOp op);
+
         //Mutation rates
 
 #define DECLARE_PROPERTY(T, G, S) \
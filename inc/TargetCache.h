@@ -0,0 +1,54 @@
+/*
+ *  Evoimage-gl, a library and program to evolve images
+ *  Copyright (C) 2009 Brent Burton
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+/*
+ * TargetCache
+ * A directory of prepared TargetImages, named by a hash of the source
+ * file's bytes plus everything that changes the prepared data. A hit
+ * is mapped straight from disk instead of decoding and preparing.
+ */
+#pragma once
+
+#include <string>
+#include "TargetImage.h"
+
+namespace ei
+{
+    class TargetCache
+    {
+      protected:
+        std::string m_directory;
+
+      public:
+        TargetCache(std::string const &directory);
+
+        // 64-bit FNV-1a of a file's contents. Returns false if unreadable.
+        static bool hashFile(const char *filename, uint64_t &hash);
+
+        // Cache entry path for a source image prepared with these
+        // parameters, or "" if the source cannot be read.
+        std::string entryFor(const char *sourceFilename,
+                             int width, int height, int tileSize);
+
+        // Map an existing entry into target. False on a miss or stale entry.
+        bool load(std::string const &entry, TargetImage &target);
+
+        // Write target as entry. Safe against concurrent writers.
+        bool store(std::string const &entry, TargetImage const &target);
+    };
+}
@@ -0,0 +1,159 @@
+/*
+ *  Evoimage-gl, a library and program to evolve images
+ *  Copyright (C) 2009 Brent Burton
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+/*
+ * TargetImage
+ * The environment (target) image, prepared once at load time into
+ * everything the evaluators want: aligned planar R/G/B and Y/Cb/Cr,
+ * a 2x pyramid, summed area tables, and per-tile statistics.
+ *
+ * All of it lives in one aligned block that is never modified after
+ * load(), so a TargetImage may be shared by any number of evaluator
+ * threads through const references. Candidates are compared directly
+ * from their 32-bit BGRX rendering buffers.
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace ei
+{
+    enum DiffMode
+    {
+        DiffRgb,                            // euclidean distance of RGB, every pixel
+        DiffYcc                             // L1 of Y, plus Cb/Cr at half resolution
+    };
+
+    enum TargetPlane
+    {
+        PlaneR, PlaneG, PlaneB,             // full resolution, and every pyramid level
+        PlaneY, PlaneCb, PlaneCr,           // level 0 only; Cb/Cr are half resolution
+        PlaneCount
+    };
+
+    struct TileStats
+    {
+        float r, g, b;                      // mean color of the tile
+        float variance;                     // variance of luma over the tile
+    };
+
+    class TargetImage
+    {
+      public:
+        static const int alignment = 64;    // plane rows start on cache lines
+        static const int maxLevels = 8;     // pyramid levels, including level 0
+
+        // Bumped whenever the layout or any derived data changes
+        static const uint32_t formatVersion;
+
+      protected:
+        int m_width;
+        int m_height;
+        int m_tileSize;
+        int m_lumaWeight;
+        int m_chromaWeight;
+
+        struct Layout
+        {
+            int    levels;
+            int    levelWidth[maxLevels];
+            int    levelHeight[maxLevels];
+            int    levelStride[maxLevels];
+            size_t rgbOffset[maxLevels][3]; // R,G,B planes of each level
+            int    chromaWidth, chromaHeight, chromaStride;
+            size_t yOffset, cbOffset, crOffset;
+            size_t integralOffset[3];       // (width+1) x (height+1) uint32_t
+            int    tilesX, tilesY;
+            size_t tileOffset;              // tilesX x tilesY TileStats
+            size_t size;
+        } m_layout;
+
+        uint8_t *m_arena;                   // everything above, one allocation
+        bool     m_ownsArena;
+        void    *m_mapping;                 // set when the arena lives in a mapped file
+        size_t   m_mappingSize;
+
+        void computeLayout(int width, int height, int tileSize);
+        void release();
+
+        uint8_t *planeData(TargetPlane p, int level);
+        uint32_t *integralData(int channel);
+
+      private:
+        TargetImage(TargetImage const &);
+        TargetImage &operator=(TargetImage const &);
+
+      public:
+        TargetImage();
+        ~TargetImage();
+
+        // Convert a BGRX image (Cairo RGB24/ARGB32 byte order) and build
+        // all derived data. tileSize is the edge of the statistics tiles.
+        bool load(const uint8_t *bgrx, int width, int height, int stride,
+                  int tileSize = 16);
+
+        // Exchange contents with another image, e.g. one prepared on
+        // another thread
+        void swap(TargetImage &other);
+
+        int width() const;
+        int height() const;
+
+        // Planes. Rows are planeStride() bytes apart and 64-byte aligned.
+        const uint8_t *plane(TargetPlane p, int level = 0) const;
+        int planeStride(TargetPlane p, int level = 0) const;
+
+        // Pyramid: level n is (roughly) the full image scaled by 1/2^n
+        int levels() const;
+        int levelWidth(int level) const;
+        int levelHeight(int level) const;
+
+        // Summed area tables for R, G, B (channel 0..2)
+        const uint32_t *integral(int channel) const;
+        uint32_t regionSum(int channel, int x0, int y0, int x1, int y1) const;
+
+        // Per-tile statistics
+        int tileSize() const;
+        int tilesX() const;
+        int tilesY() const;
+        const TileStats &tileStats(int tx, int ty) const;
+
+        // Per-sample weights of the Y and Cb/Cr planes in DiffYcc mode
+        void setYccWeights(int lumaWeight, int chromaWeight);
+
+        // Euclidean RGB difference of a BGRX candidate over [x0,x1) x [y0,y1)
+        uint32_t differenceRgb(const uint8_t *bgrx, int stride,
+                               int x0, int y0, int x1, int y1) const;
+
+        // Difference of a BGRX candidate against the Y/Cb/Cr planes over
+        // the rectangle [x0,x1) x [y0,y1). The rectangle is widened to
+        // even coordinates so chroma blocks are never split.
+        uint32_t differenceYcc(const uint8_t *bgrx, int stride,
+                               int x0, int y0, int x1, int y1) const;
+
+        uint32_t difference(DiffMode mode, const uint8_t *bgrx, int stride,
+                            int x0, int y0, int x1, int y1) const;
+
+        // Write the prepared block to a file, or map a previously written
+        // one read-only in place of load(). map() fails (leaving the image
+        // empty) if the file was written with a different formatVersion.
+        bool save(const char *filename) const;
+        bool map(const char *filename);
+    };
+}
@@ -0,0 +1,69 @@
+/*
+ *  Evoimage-gl, a library and program to evolve images
+ *  Copyright (C) 2009 Brent Burton
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+/*
+ * TileErrorMap
+ * The difference of a drawing against the target, kept per square
+ * tile. A child only re-diffs the tiles its mutations touched; the
+ * rest of its map, and its total, carry over from the parent.
+ */
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include "DnaRect.h"
+
+namespace ei
+{
+    class TileErrorMap
+    {
+      protected:
+        int m_width;
+        int m_height;
+        int m_tileSize;
+        int m_tilesX;
+        int m_tilesY;
+        std::vector<uint32_t> m_errors;     // row-major, tilesX x tilesY
+        uint32_t m_total;
+
+      public:
+        TileErrorMap();
+
+        // Clear to a zero-error grid covering width x height pixels
+        void reset(int width, int height, int tileSize);
+
+        int tileSize() const;
+        int tilesX() const;
+        int tilesY() const;
+
+        // Pixel rectangle of a tile, clipped to the image
+        DnaRect tileRect(int tx, int ty) const;
+
+        // Tiles [tx0,tx1) x [ty0,ty1) overlapping a pixel rectangle.
+        // Returns false if the rectangle misses the image entirely.
+        bool tileSpan(DnaRect const &rect, int &tx0, int &ty0, int &tx1, int &ty1) const;
+
+        uint32_t error(int tx, int ty) const;
+        void setError(int tx, int ty, uint32_t error);
+
+        uint32_t total() const;
+
+        // Tile with the largest error
+        void worstTile(int &tx, int &ty) const;
+    };
+}
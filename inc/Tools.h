@@ -18,8 +18,19 @@
  */
 #pragma once
 
+#include <cstdint>
+
 namespace ei
 {
+    // Chooses canvas positions for new polygons and for the largest
+    // point moves, in place of a uniform draw.
+    class PositionSampler
+    {
+      public:
+        virtual ~PositionSampler();
+        virtual void sample(int &x, int &y) = 0;
+    };
+
     namespace Tools
     {
         extern const int maxWidth;
@@ -28,6 +39,23 @@ namespace ei
 
         int getRandomNumber(int min, int max);
         bool willMutate(int mutationRate);
+
+        // Give the calling thread its own random stream, independent of
+        // rand() and of every other thread. Threads that never call this
+        // share rand(), so srand() keeps working as it always has.
+        void seedThread(uint64_t seed);
+
+        // A position within the bounds: uniform, unless a sampler is
+        // installed. Pass 0 to go back to uniform. The sampler is per
+        // thread.
+        void getRandomPosition(int &x, int &y);
+        void setPositionSampler(PositionSampler *sampler);
+
+        // Confine this thread's new and moved points to [x0,x1] x [y0,y1]
+        // (inclusive), e.g. to evolve one region of the canvas. The
+        // bounds start out as [0,maxWidth] x [0,maxHeight].
+        void setBounds(int x0, int y0, int x1, int y1);
+        void clampPosition(int &x, int &y);
     }
 
 }
@@ -0,0 +1,95 @@
+/*
+ *  Evoimage-gl, a library and program to evolve images
+ *  Copyright (C) 2009 Brent Burton
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+/*
+ * TraceBuffer
+ * Optional timeline of the run in Chrome trace-event form, viewable in
+ * chrome://tracing or Perfetto. Code marks spans with a TraceScope;
+ * each finished span is one complete ("X") event in a ring buffer owned
+ * by the recording thread, so memory stays bounded however long the
+ * run, and the oldest events are overwritten first. Rings grow as they
+ * fill, so idle threads cost little. While tracing is off a TraceScope
+ * only tests a flag.
+ */
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+namespace ei
+{
+    class TraceBuffer
+    {
+      public:
+        typedef std::chrono::steady_clock Clock;
+
+        struct Event
+        {
+            const char *name;               // must outlive the buffer; use literals
+            uint64_t    start;              // ns since start()
+            uint64_t    duration;           // ns
+        };
+
+      protected:
+        static bool              s_enabled;
+        static size_t            s_capacity;
+        static Clock::time_point s_origin;
+
+      public:
+        // Start recording, keeping the last eventsPerThread events of each thread
+        static void start(size_t eventsPerThread);
+        static bool enabled()
+        { return s_enabled; }
+
+        // Name the calling thread in the trace
+        static void setThreadName(const char *name);
+
+        static void record(const char *name, Clock::time_point start, Clock::time_point end);
+
+        // Drop every event recorded so far, e.g. in a forked child that
+        // writes its own trace
+        static void discard();
+
+        // Stop recording and write every thread's events as trace JSON.
+        // No thread may be recording while this runs.
+        static bool write(const char *filename);
+    };
+
+    class TraceScope
+    {
+      protected:
+        const char *m_name;
+        bool m_on;
+        TraceBuffer::Clock::time_point m_start;
+
+      public:
+        TraceScope(const char *name)
+            : m_name(name), m_on(TraceBuffer::enabled())
+        {
+            if (m_on)
+                m_start = TraceBuffer::Clock::now();
+        }
+
+        ~TraceScope()
+        {
+            if (m_on)
+                TraceBuffer::record(m_name, m_start, TraceBuffer::Clock::now());
+        }
+    };
+}
@@ -0,0 +1,489 @@
+/*
+ *  evobench - seeded microbenchmarks of the evolver's hot paths.
+ *  Part of evoimage-gl, a library and program to evolve images
+ *  Copyright (C) 2009-2022 Brent Burton
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include <cairo.h>
+#include <unistd.h>
+#include <iostream>
+#include <fstream>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <functional>
+#include <memory>
+#include <json/json.h>
+
+#include "Settings.h"
+#include "Tools.h"
+#include "DnaDrawing.h"
+#include "TargetImage.h"
+#include "CairoRender.h"
+#include "DrawingJson.h"
+
+/*
+ * Each benchmark reseeds rand() with the same seed before it runs, and
+ * works on drawings and targets generated from that seed, so runs of
+ * the same build do the same work. A benchmark is calibrated to take
+ * about (min time / samples) per sample; the median sample is reported.
+ */
+
+struct ProgramArgs {
+    std::string outFilename;                // JSON results
+    std::string baselineFilename;           // earlier results to compare against
+    std::string filter;                     // run benchmarks whose name contains this
+    std::string scratchDir;                 // for the PNG and JSON files
+    double minTime;                         // seconds per benchmark
+    int samples;
+    unsigned seed;
+};
+ProgramArgs g_args {"", "", "", ".", 0.5, 5, 1};
+
+struct BenchResult {
+    std::string name;
+    double nsPerOp;                         // median of the samples
+    double minNs;
+    double maxNs;
+    uint64_t iterations;                    // per sample
+};
+std::vector<BenchResult> g_results;
+
+static const int polygonBudgets[] = {50, 255};
+static const int canvasSizes[] = {200, 400, 800};
+
+void usage()
+{
+    std::cout << "usage: evobench [options]\n"
+              << "Switches:\n"
+              << "    -o file     Write the results as JSON to 'file'\n"
+              << "    -b file     Compare against results saved earlier with -o\n"
+              << "    -f text     Only run benchmarks whose name contains 'text'\n"
+              << "    -d dir      Directory for scratch PNG and JSON files (default .)\n"
+              << "    -t seconds  Time to spend per benchmark (default 0.5)\n"
+              << "    -n samples  Samples per benchmark (default 5)\n"
+              << "    -s seed     Seed for drawings, targets and mutations (default 1)\n"
+              << std::endl;
+    exit(1);
+}
+
+void checkArgs(int argc, char *argv[])
+{
+    int option;
+    while (-1 != (option = getopt(argc, argv, "o:b:f:d:t:n:s:")) )
+    {
+        switch (option)
+        {
+          case 'o':
+            g_args.outFilename = optarg;
+            break;
+          case 'b':
+            g_args.baselineFilename = optarg;
+            break;
+          case 'f':
+            g_args.filter = optarg;
+            break;
+          case 'd':
+            g_args.scratchDir = optarg;
+            break;
+          case 't':
+            if (1 != sscanf(optarg, "%lf", &g_args.minTime) || g_args.minTime <= 0)
+            {
+                std::cout << "invalid number for -t\n";
+                usage();
+            }
+            break;
+          case 'n':
+            if (1 != sscanf(optarg, "%d", &g_args.samples) || g_args.samples < 1)
+            {
+                std::cout << "invalid number for -n\n";
+                usage();
+            }
+            break;
+          case 's':
+            if (1 != sscanf(optarg, "%u", &g_args.seed))
+            {
+                std::cout << "invalid number for -s\n";
+                usage();
+            }
+            break;
+
+          case '?':
+          default:
+            usage();
+            break;
+        }
+    }
+}
+
+/*
+ * Time body, which performs one operation per call.
+ */
+static void runBench(std::string const &name, std::function<void()> body)
+{
+    typedef std::chrono::steady_clock Clock;
+
+    if (g_args.filter.length() && std::string::npos == name.find(g_args.filter))
+        return;
+
+    srand(g_args.seed);
+    double sampleTime = g_args.minTime / g_args.samples;
+
+    // Calibrate: double the batch until it runs for a tenth of a sample
+    uint64_t iterations = 1;
+    for (;;)
+    {
+        Clock::time_point start = Clock::now();
+        for (uint64_t i = 0; i < iterations; i++)
+            body();
+        double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+        if (seconds >= sampleTime / 10)
+        {
+            iterations = std::max<uint64_t>(1, iterations * sampleTime / seconds);
+            break;
+        }
+        iterations *= 2;
+    }
+
+    std::vector<double> ns;
+    srand(g_args.seed);
+    for (int s = 0; s < g_args.samples; s++)
+    {
+        Clock::time_point start = Clock::now();
+        for (uint64_t i = 0; i < iterations; i++)
+            body();
+        ns.push_back(std::chrono::duration<double, std::nano>(Clock::now() - start).count() /
+                     iterations);
+    }
+    std::sort(ns.begin(), ns.end());
+
+    BenchResult result = {name, ns[ns.size() / 2], ns.front(), ns.back(), iterations};
+    g_results.push_back(result);
+
+    char line[160];
+    snprintf(line, sizeof(line), "%-28s %14.1f ns/op  (%.1f .. %.1f, %llu iterations)",
+             name.c_str(), result.nsPerOp, result.minNs, result.maxNs,
+             (unsigned long long)iterations);
+    std::cout << line << std::endl;
+}
+
+static std::string benchName(const char *group, int a, int b = 0)
+{
+    char name[64];
+    if (b)
+        snprintf(name, sizeof(name), "%s/%d/%d", group, a, b);
+    else
+        snprintf(name, sizeof(name), "%s/%d", group, a);
+    return name;
+}
+
+/*
+ * A drawing of n polygons of realistic size: 3..8 points scattered
+ * around a random center, and a random translucent brush.
+ */
+static ei::DnaDrawing *makeDrawing(int polygons)
+{
+    srand(g_args.seed);
+    ei::DnaDrawing *d = new ei::DnaDrawing();
+    ei::DnaPolygonList list;
+    for (int i = 0; i < polygons; i++)
+    {
+        ei::DnaPolygon poly;
+        int cx = ei::Tools::getRandomNumber(0, ei::Tools::maxWidth);
+        int cy = ei::Tools::getRandomNumber(0, ei::Tools::maxHeight);
+        int radius = ei::Tools::getRandomNumber(5, 60);
+        ei::DnaPointList points;
+        int count = ei::Tools::getRandomNumber(3, 8);
+        for (int j = 0; j < count; j++)
+        {
+            int x = cx + ei::Tools::getRandomNumber(-radius, radius);
+            int y = cy + ei::Tools::getRandomNumber(-radius, radius);
+            points.push_back(ei::DnaPoint(std::min(std::max(0, x), ei::Tools::maxWidth),
+                                          std::min(std::max(0, y), ei::Tools::maxHeight)));
+        }
+        poly.setPoints(points);
+        poly.setBrush(ei::DnaBrush(ei::Tools::getRandomNumber(0, 255),
+                                   ei::Tools::getRandomNumber(0, 255),
+                                   ei::Tools::getRandomNumber(0, 255),
+                                   ei::Tools::getRandomNumber(30, 60)));
+        list.push_back(poly);
+    }
+    d->setPolygons(list);
+    return d;
+}
+
+/*
+ * Render the whole drawing, scaled to a size x size canvas.
+ */
+static cairo_surface_t *renderDrawing(ei::DnaDrawing *d, int size)
+{
+    return ei::CairoRender::render(d, size, size);
+}
+
+/*
+ * A deterministic target: smooth gradients with some seeded noise.
+ */
+static cairo_surface_t *makeTarget(int size)
+{
+    srand(g_args.seed);
+    cairo_surface_t *surface = cairo_image_surface_create(CAIRO_FORMAT_RGB24, size, size);
+    cairo_surface_flush(surface);
+    uint8_t *data = cairo_image_surface_get_data(surface);
+    int stride = cairo_image_surface_get_stride(surface);
+    for (int y = 0; y < size; y++)
+    {
+        uint8_t *px = data + y * stride;
+        for (int x = 0; x < size; x++, px += 4)
+        {
+            int noise = ei::Tools::getRandomNumber(-16, 16);
+            px[0] = std::min(255, std::max(0, 255 * x / size + noise));
+            px[1] = std::min(255, std::max(0, 255 * y / size + noise));
+            px[2] = std::min(255, std::max(0, 255 * (x + y) / (2 * size) + noise));
+            px[3] = 0;
+        }
+    }
+    cairo_surface_mark_dirty(surface);
+    return surface;
+}
+
+static void writeJson(Json::Value const &value, std::string const &filename)
+{
+    std::ofstream outfile(filename);
+    Json::StreamWriterBuilder builder;
+    builder["indentation"] = "    ";
+    std::unique_ptr<Json::StreamWriter> writer( builder.newStreamWriter() );
+    writer->write(value, &outfile);
+}
+
+static void benchEngine()
+{
+    for (int budget: polygonBudgets)
+    {
+        ei::DnaDrawing *drawing = makeDrawing(budget);
+
+        runBench(benchName("clone", budget), [&]() {
+            delete drawing->clone();
+        });
+
+        // Mutate a working copy in place, starting over every 256
+        // mutations so it cannot drift far from the budget
+        ei::DnaDrawing *work = drawing->clone();
+        unsigned count = 0;
+        runBench(benchName("mutate", budget), [&]() {
+            if (0 == ++count % 256)
+            {
+                delete work;
+                work = drawing->clone();
+            }
+            work->mutate();
+        });
+        delete work;
+        delete drawing;
+    }
+}
+
+static void benchRender()
+{
+    for (int budget: polygonBudgets)
+    {
+        ei::DnaDrawing *drawing = makeDrawing(budget);
+        for (int size: canvasSizes)
+        {
+            runBench(benchName("render/full", budget, size), [&]() {
+                cairo_surface_destroy(renderDrawing(drawing, size));
+            });
+        }
+
+        // A child's usual footprint: one polygon-sized clip over the parent
+        cairo_surface_t *base = renderDrawing(drawing, 200);
+        runBench(benchName("render/clip32", budget), [&]() {
+            int x = ei::Tools::getRandomNumber(0, 200 - 32);
+            int y = ei::Tools::getRandomNumber(0, 200 - 32);
+            cairo_surface_destroy(ei::CairoRender::renderOver(drawing, base,
+                                                              ei::DnaRect(x, y, x + 32, y + 32)));
+        });
+        cairo_surface_destroy(base);
+        delete drawing;
+    }
+}
+
+static void benchDiff()
+{
+    ei::DnaDrawing *drawing = makeDrawing(50);
+    for (int size: canvasSizes)
+    {
+        cairo_surface_t *targetSurface = makeTarget(size);
+        cairo_surface_t *candidate = renderDrawing(drawing, size);
+        const uint8_t *data = cairo_image_surface_get_data(candidate);
+        int stride = cairo_image_surface_get_stride(candidate);
+
+        ei::TargetImage target;
+        target.load(cairo_image_surface_get_data(targetSurface), size, size,
+                    cairo_image_surface_get_stride(targetSurface));
+
+        uint32_t sink = 0;
+        runBench(benchName("diff/rgb", size), [&]() {
+            sink += target.differenceRgb(data, stride, 0, 0, size, size);
+        });
+        runBench(benchName("diff/ycc", size), [&]() {
+            sink += target.differenceYcc(data, stride, 0, 0, size, size);
+        });
+        if (size == 200)
+        {
+            runBench("diff/rgb-tile16", [&]() {
+                sink += target.differenceRgb(data, stride, 96, 96, 112, 112);
+            });
+            runBench("diff/ycc-tile16", [&]() {
+                sink += target.differenceYcc(data, stride, 96, 96, 112, 112);
+            });
+            runBench("target/load", [&]() {
+                ei::TargetImage t;
+                t.load(cairo_image_surface_get_data(targetSurface), size, size,
+                       cairo_image_surface_get_stride(targetSurface));
+            });
+        }
+        if (sink == 1)                      // keep the kernels from being optimized away
+            std::cout << ' ';
+
+        cairo_surface_destroy(candidate);
+        cairo_surface_destroy(targetSurface);
+    }
+    delete drawing;
+}
+
+static void benchFiles()
+{
+    std::string png = g_args.scratchDir + "/evobench-scratch.png";
+    std::string json = g_args.scratchDir + "/evobench-scratch.json";
+
+    ei::DnaDrawing *drawing = makeDrawing(50);
+    for (int size: canvasSizes)
+    {
+        cairo_surface_t *image = renderDrawing(drawing, size);
+        runBench(benchName("png/save", size), [&]() {
+            cairo_surface_write_to_png(image, png.c_str());
+        });
+        runBench(benchName("png/load", size), [&]() {
+            cairo_surface_destroy(cairo_image_surface_create_from_png(png.c_str()));
+        });
+        cairo_surface_destroy(image);
+    }
+    delete drawing;
+
+    for (int budget: polygonBudgets)
+    {
+        drawing = makeDrawing(budget);
+        runBench(benchName("json/save", budget), [&]() {
+            ei::DrawingJson::save(drawing, json);
+        });
+        runBench(benchName("json/load", budget), [&]() {
+            std::ifstream ins(json);
+            Json::Value value;
+            ins >> value;
+        });
+        delete drawing;
+    }
+
+    unlink(png.c_str());
+    unlink(json.c_str());
+}
+
+/*
+ * Print the change of each benchmark against a baseline run.
+ */
+static void compareBaseline()
+{
+    std::ifstream ins(g_args.baselineFilename);
+    if (!ins.is_open())
+    {
+        std::cout << "Cannot open baseline " << g_args.baselineFilename << std::endl;
+        return;
+    }
+    Json::Value baseline;
+    ins >> baseline;
+
+    std::cout << "\nCompared to " << g_args.baselineFilename << ":\n";
+    Json::Value &benchmarks = baseline["benchmarks"];
+    for (auto &result: g_results)
+    {
+        for (uint32_t i = 0; i < benchmarks.size(); i++)
+        {
+            if (benchmarks[i]["name"].asString() != result.name)
+                continue;
+            double before = benchmarks[i]["ns_per_op"].asDouble();
+            char line[160];
+            snprintf(line, sizeof(line), "%-28s %14.1f -> %14.1f ns/op  %+6.1f%%",
+                     result.name.c_str(), before, result.nsPerOp,
+                     100.0 * (result.nsPerOp - before) / before);
+            std::cout << line << std::endl;
+        }
+    }
+}
+
+static void saveResults()
+{
+    Json::Value results;
+    results["version"] = 1;
+    results["seed"] = g_args.seed;
+    results["samples"] = g_args.samples;
+    results["min_time"] = g_args.minTime;
+    results["compiler"] = __VERSION__;
+    results["date"] = Json::Int64(time(NULL));
+
+    Json::Value benchmarks(Json::arrayValue);
+    for (auto &result: g_results)
+    {
+        Json::Value bench;
+        bench["name"] = result.name;
+        bench["ns_per_op"] = result.nsPerOp;
+        bench["min_ns"] = result.minNs;
+        bench["max_ns"] = result.maxNs;
+        bench["iterations"] = Json::UInt64(result.iterations);
+        benchmarks.append(bench);
+    }
+    results["benchmarks"] = benchmarks;
+
+    writeJson(results, g_args.outFilename);
+    std::cout << "Wrote results to " << g_args.outFilename << std::endl;
+}
+
+int main(int argc, char **argv)
+{
+    checkArgs(argc, argv);
+
+    ei::Settings settings;
+    settings.setPolygonsMax(255);
+    settings.activate();
+
+    benchEngine();
+    benchRender();
+    benchDiff();
+    benchFiles();
+
+    if (g_args.baselineFilename.length())
+        compareBaseline();
+    if (g_args.outFilename.length())
+        saveResults();
+
+    return 0;
+}
@@ -19,6 +19,8 @@
 
 #include <cairo.h>
 #include <unistd.h>
+#include <sys/wait.h>
+#include <getopt.h>
 #include <iostream>
 #include <fstream>
 #include <stdio.h>
@@ -27,28 +29,75 @@
 #include <cmath>
 #include <cstdint>
 #include <string>
+#include <cstring>
 #include <json/json.h>
 #include <memory>
+#include <vector>
+#include <deque>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <climits>
+#include <new>
 
 #include "Settings.h"
 #include "Tools.h"
 #include "DnaDrawing.h"
+#include "TargetImage.h"
+#include "TargetCache.h"
+#include "TileErrorMap.h"
+#include "GuidedSampler.h"
+#include "AdaptiveRates.h"
+#include "MutationStats.h"
+#include "PhaseProfiler.h"
+#include "AllocationCounter.h"
+#include "TraceBuffer.h"
+#include "Probes.h"
+#include "LiveStats.h"
+#include "IslandMailbox.h"
+#include "AcceptancePolicy.h"
+#include "PlateauDetector.h"
+#include "Initializer.h"
+#include "ComplexityCost.h"
+#include "CairoRender.h"
+#include "DrawingJson.h"
 
 // Func prototypes
 static void doNextMutation();               // do next mutation & compare
 static void generateFirstDrawing();
 static int loadEnvironmentPng();
+static void saveOpStats();
 static cairo_surface_t *renderDrawing(ei::DnaDrawing *d);
+static cairo_surface_t *renderDrawingOver(ei::DnaDrawing *d, cairo_surface_t *base,
+                                          ei::DnaRect const &clip);
 
-// global variables
-static int g_generationCount = 0;
+// global variables. Those describing the lineage being evolved are per
+// thread, so that each --islands thread evolves its own.
+static thread_local int g_generationCount = 0;
 static int g_imageNum = 0;
 static const int g_width  = 200;
 static const int g_height = 200;
 
 static cairo_surface_t *g_environmentImage;
-ei::DnaDrawing *g_lastDrawing = 0;
-uint32_t g_lastDifference;
+static ei::TargetImage g_target;            // environment, prepared at load
+thread_local ei::DnaDrawing *g_lastDrawing = 0;
+thread_local uint32_t g_lastDifference;
+thread_local cairo_surface_t *g_lastImage = 0;  // rendering of g_lastDrawing
+thread_local int g_lastImprovement = 0;     // generation g_lastDrawing improved
+thread_local bool g_worker = false;         // one of several lineages; output is the main thread's
+thread_local ei::TileErrorMap g_lastErrors; // per-tile difference of g_lastImage
+thread_local ei::GuidedSampler *g_guidedSampler = 0; // set when --guided is in effect
+ei::AdaptiveRates *g_adaptiveRates = 0;     // set when --adapt-rates is in effect
+thread_local ei::MutationStats g_mutationStats; // per-operator telemetry of all children
+thread_local ei::PhaseProfiler *g_profiler = 0; // set when --profile is in effect
+ei::AcceptancePolicy *g_acceptance = 0;     // whether a child replaces its parent
+thread_local ei::DnaDrawing *g_bestDrawing = 0; // best so far, if the policy may lose it
+thread_local uint32_t g_bestDifference;
+thread_local uint32_t g_bestFitness;
+ei::ComplexityCost g_complexity;            // penalty on top of the difference, if any
+ei::LiveStats g_liveStats;                  // open when --live-stats is in effect
+FILE *g_progressFile = 0;                   // set when --progress is in effect
+std::chrono::steady_clock::time_point g_processStart = std::chrono::steady_clock::now();
 
 time_t g_startTime = 0;
 time_t g_endTime = 0;
@@ -61,91 +110,126 @@ typedef struct {
     int pointsMax;
     char *environmentFilename;
     std::string jsonFilename;
+    ei::DiffMode diffMode;
+    int lumaWeight;
+    int chromaWeight;
+    std::string targetCacheDir;
+    int tileSize;                           // edge of error map & statistics tiles
+    bool fullEvaluation;                    // render and diff whole children
+    int guidedPercent;                      // share of positions drawn from the residual
+    bool refitChildren;                     // refit colors of changed polygons
+    int refitEvery;                         // refit all parent colors every n gens
+    int polishStall;                        // polish after n gens without progress
+    int polishEnd;                          // polish passes after the last generation
+    int pruneEvery;                         // prune the parent every n gens, and at the end
+    double pruneTolerance;                  // ...letting the difference grow by this percentage
+    int adaptEvery;                         // re-weight mutation rates every n gens
+    int adaptBound;                         // ...within base/bound .. base*bound
+    std::string opStatsFilename;            // per-operator telemetry, .json or CSV
+    int opStatsEvery;                       // ...written every n gens
+    bool profile;                           // time the phases of each generation
+    std::string profileFilename;            // ...and append CSV records here
+    std::string traceFilename;              // trace-event timeline output
+    int traceEvents;                        // ...keeping this many events per thread
+    std::string liveStatsFilename;          // shared stats page for monitors
+    std::string progressFilename;           // difference vs. time, as CSV
+    unsigned seed;                          // -s, or rand()'s default of 1
+    int islands;                            // lineages evolved side by side; 0 = off
+    bool islandProcesses;                   // ...in forked workers, not threads
+    int migrateEvery;                       // islands swap best drawings every n gens
+    bool randomTopology;                    // ...with a random island, not the next
+    int population;                         // mu of a (mu+lambda) population; 0 = off
+    int tournamentSize;                     // parents are the best of this many
+    int crossoverPercent;                   // share of children crossed over
+    int evalThreads;                        // threads scoring a population's children
+    int acceptance;                         // AcceptGreedy, AcceptAnneal, AcceptThreshold
+    double acceptStart;                     // temperature or threshold, as a fraction
+    double acceptEnd;                       // ...of the parent's difference
+    ei::CoolingSchedule cooling;
+    double deadline;                        // stop after this many seconds; 0 = none
+    uint32_t targetDifference;              // stop once the difference is this low
+    int plateauWindow;                      // stop if n generations gained too little
+    double plateauGain;                     // ...namely less than this percentage
+    int restarts;                           // restart on plateau this often before stopping
+    int perturbRounds;                      // mutate() calls to perturb a restart
+    bool sequence;                          // positional arguments are frames
+    int frameGenerations;                   // generations of each later frame; 0 = -g
+    bool pipeline;                          // load and write frames in the background
+    std::vector<std::string> frames;
+    int splitColumns;                       // evolve the canvas as columns x rows
+    int splitRows;                          // ...regions in parallel; 0 = off
+    int splitOverlap;                       // pixels regions reach into their neighbors
+    int splitRefine;                        // generations refining the merged drawing
+    int initMode;                           // InitRandom, InitGrid, InitKmeans
+    int initPolygons;                       // ...seeding this many; 0 = half of -p
+    uint32_t polygonCost;                   // added to the difference per polygon
+    uint32_t vertexCost;                    // ...and per vertex
+    double areaBudget;                      // most filled area, in canvases; 0 = none
 } ProgramArgs;
 
-ProgramArgs g_programArgs = {300, 1, 10000, 50, 20, 0};
+enum {
+    AcceptGreedy,
+    AcceptAnneal,
+    AcceptThreshold
+};
+
+enum {
+    InitRandom,
+    InitGrid,
+    InitKmeans
+};
+
+ProgramArgs g_programArgs = {300, 1, 10000, 50, 20, 0, "", ei::DiffRgb, 1, 1, "",
+                             16, false, 0, false, 0, 0, 0, 0, 0.1, 0, 4, "", 2000, false, "", "", 1 << 20, "", "",
+                             1, 0, false, 500, false, 0, 2, 0, 1,
+                             AcceptGreedy, 0, 0, ei::CoolExponential,
+                             0, 0, 0, 0.1, 0, 10,
+                             false, 0, false, {},
+                             0, 0, 8, 1000,
+                             InitRandom, 0,
+                             0, 0, 0};
 
 
 // other imaging routines
+
 static cairo_surface_t* renderDrawing(ei::DnaDrawing *d)
 {
-    cairo_surface_t *surface = 0;
-    cairo_t *ctx = 0;
-
-    surface = cairo_image_surface_create(CAIRO_FORMAT_RGB24, g_width, g_height);
-    if (cairo_surface_status(surface) == CAIRO_STATUS_SUCCESS)
-    {
-        ctx = cairo_create(surface);
-        if (cairo_status(ctx) == CAIRO_STATUS_SUCCESS)
-        {
-
-            // Clear the current buffer to black:
-            cairo_pattern_t *pattern = cairo_pattern_create_rgb(0.0, 0.0, 0.0);
-            cairo_set_source(ctx, pattern);
-            cairo_pattern_destroy(pattern);
-            cairo_paint(ctx);                       // fills clip region
-
-            // render image:
-            // * for each polygon:
-            ei::DnaPolygonList &polys = d->polygons();
-            ei::DnaPolygonList::iterator iter;
-            for (iter = polys.begin(); iter != polys.end(); iter++)
-            {
-                ei::DnaPolygon &poly = *iter;
-                // Create path:
-                ei::DnaPointList &points = poly.points();
-                cairo_move_to(ctx, points[0].x, points[0].y);
-                for (int i=1; i < points.size(); i++)
-                {
-                    cairo_line_to(ctx, points[i].x, points[i].y);
-                }
-                cairo_close_path(ctx);
-
-                // ** allocate its color & alpha
-                ei::DnaBrush &brush = poly.brush();
-                cairo_set_source_rgba(ctx,
-                                      brush.r / 255.0, brush.g / 255.0,
-                                      brush.b / 255.0, brush.a / 255.0);
-
-                cairo_fill(ctx); // fill and consume path
-            }
-        }
-        else                    // context could not be allocated
-        {
-            cairo_destroy(ctx);
-            ctx = 0;
-            cairo_surface_destroy(surface);
-            surface = 0;
-        }
-    }
-    else                        // surface could not be allocated
-    {
-        cairo_surface_destroy(surface);
-        surface = 0;
-    }
-
-    if (ctx)
-        cairo_destroy(ctx);
+    ei::PhaseTimer timer(g_profiler, ei::PhaseRender);
+    ei::TraceScope trace("render");
+    return ei::CairoRender::render(d, g_width, g_height);
+}
 
-    return surface;
+/*
+ * Render a drawing that differs from the one rendered in base only
+ * inside clip: copy base, then redraw just the clipped area.
+ */
+static cairo_surface_t* renderDrawingOver(ei::DnaDrawing *d, cairo_surface_t *base,
+                                          ei::DnaRect const &clip)
+{
+    ei::PhaseTimer timer(g_profiler, ei::PhaseRender);
+    ei::TraceScope trace("render");
+    return ei::CairoRender::renderOver(d, base, clip);
 }
 
 
 void renderImageFile(cairo_surface_t *image, int imageIndex)
 {
+    ei::PhaseTimer timer(g_profiler, ei::PhaseSnapshot);
+    ei::TraceScope trace("snapshot");
     // make new output image file
     char filename[100];
     sprintf(filename, "mutations/evoimg-%07d.png", imageIndex);
+    EI_PROBE1(snapshot_write, imageIndex);
 
     // write image out to file
     cairo_surface_write_to_png(image, filename);
 }
 
 /*
- * A multithreaded implementation.
+ * A multithreaded implementation. Each worker compares a band of rows
+ * of the candidate against the shared, read-only g_target planes.
  */
 typedef struct {
-    cairo_surface_t *oldImage;
     cairo_surface_t *newImage;
     int rowStart;
     int rowEnd;
@@ -155,27 +239,11 @@ typedef struct {
 void* diffImagesWorker(void *arg)
 {
     diffImageMTArgs *args = (diffImageMTArgs*)arg;
-    uint32_t difference = 0;
-    int x,y, mx = g_width, my = args->rowEnd;
 
-    for (y = args->rowStart; y < my; y++)
-    {
-        uint8_t *rowOld = (cairo_image_surface_get_data(args->oldImage) +
-                           y * cairo_image_surface_get_stride(args->oldImage));
-        uint8_t *rowNew = (cairo_image_surface_get_data(args->newImage) +
-                           y * cairo_image_surface_get_stride(args->newImage));
-
-        for (x = 0; x < mx; x++)
-        {
-            uint8_t *c1 = (rowOld + x * 4);
-            uint8_t *c2 = (rowNew + x * 4);
-            int r = c1[2] - c2[2];
-            int g = c1[1] - c2[1];
-            int b = c1[0] - c2[0];
-            difference += (uint32_t)std::sqrt(r*r + g*g + b*b);
-        }
-    }
-    args->result = difference;
+    args->result = g_target.difference(g_programArgs.diffMode,
+                                       cairo_image_surface_get_data(args->newImage),
+                                       cairo_image_surface_get_stride(args->newImage),
+                                       0, args->rowStart, g_width, args->rowEnd);
     return 0;
 }
 
@@ -183,24 +251,29 @@ void* diffImagesWorker(void *arg)
 
 #if SINGLE_THREAD
 
-uint32_t diffImages(cairo_surface_t *oldImage, cairo_surface_t *newImage)
+uint32_t diffImages(cairo_surface_t *newImage)
 {
-    diffImageMTArgs bottomArgs = {oldImage, newImage, 0, g_height, 0};
+    ei::PhaseTimer timer(g_profiler, ei::PhaseDiff);
+    ei::TraceScope trace("diff");
+    diffImageMTArgs bottomArgs = {newImage, 0, g_height, 0};
     diffImagesWorker(&bottomArgs);
     return bottomArgs.result;
 }
 
 #else
 
-uint32_t diffImages(cairo_surface_t *oldImage, cairo_surface_t *newImage)
+uint32_t diffImages(cairo_surface_t *newImage)
 {
-    // subthread runs top half
+    ei::PhaseTimer timer(g_profiler, ei::PhaseDiff);
+    ei::TraceScope trace("diff");
+
+    // subthread runs top half (an even row count keeps chroma blocks whole)
     pthread_t subThreadID = 0;
-    diffImageMTArgs topArgs = {oldImage, newImage, 0, g_height/2, 0};
+    diffImageMTArgs topArgs = {newImage, 0, (g_height/2) & ~1, 0};
     pthread_create(&subThreadID, NULL, diffImagesWorker, &topArgs);
 
     // main thread runs bottom half
-    diffImageMTArgs bottomArgs = {oldImage, newImage, g_height/2, g_height, 0};
+    diffImageMTArgs bottomArgs = {newImage, (g_height/2) & ~1, g_height, 0};
     diffImagesWorker(&bottomArgs);
 
     // main thread finishes, and waits for subthread
@@ -211,10 +284,204 @@ uint32_t diffImages(cairo_surface_t *oldImage, cairo_surface_t *newImage)
 }
 #endif // !SINGLE_THREAD
 
+/*
+ * Re-diff the tiles [tx0,tx1) x [ty0,ty1) of image into errors.
+ */
+static void diffTiles(cairo_surface_t *image, ei::TileErrorMap &errors,
+                      int tx0, int ty0, int tx1, int ty1)
+{
+    ei::PhaseTimer timer(g_profiler, ei::PhaseDiff);
+    ei::TraceScope trace("diff");
+    const uint8_t *data = cairo_image_surface_get_data(image);
+    int stride = cairo_image_surface_get_stride(image);
+
+    for (int ty = ty0; ty < ty1; ty++)
+    {
+        for (int tx = tx0; tx < tx1; tx++)
+        {
+            ei::DnaRect r = errors.tileRect(tx, ty);
+            errors.setError(tx, ty, g_target.difference(g_programArgs.diffMode, data, stride,
+                                                        r.x0, r.y0, r.x1, r.y1));
+        }
+    }
+}
+
+/*
+ * Pixel rectangle of the tiles [tx0,tx1) x [ty0,ty1)
+ */
+static ei::DnaRect tileClip(int tx0, int ty0, int tx1, int ty1)
+{
+    return ei::DnaRect(tx0 * g_programArgs.tileSize, ty0 * g_programArgs.tileSize,
+                       std::min(tx1 * g_programArgs.tileSize, g_width),
+                       std::min(ty1 * g_programArgs.tileSize, g_height));
+}
+
+/*
+ * A candidate drawing, its rendering, and its difference.
+ */
+struct DrawingInfo {
+    ei::DnaDrawing   *drawing;
+    cairo_surface_t  *image;                // 0 when identical to the parent's
+    ei::TileErrorMap  errors;
+    uint32_t          difference;
+    uint32_t          fitness;              // what selection ranks it by
+};
+
+/*
+ * Closed-form least-squares color for one polygon. With its shape and
+ * alpha fixed, every pixel of the final image is linear in the brush
+ * color: F = m + k * c/255, where m is the composite with c = 0 and k
+ * is how much of a white brush survives to the output (alpha times
+ * the transmittance of everything drawn above). Rendering the clip
+ * with black and with white brushes gives m and k for each channel,
+ * and the best c is 255 * sum(k*(T-m)) / sum(k*k) over covered pixels.
+ *
+ * image must be a rendering of d (at least outside the polygon's
+ * bounds). Returns false if the polygon covers no pixel; otherwise the
+ * brush holds the refit color.
+ */
+static bool refitPolygonColor(ei::DnaDrawing *d, int index, cairo_surface_t *image)
+{
+    ei::DnaPolygon &poly = d->polygons()[index];
+    ei::DnaRect clip = poly.bounds();
+    clip.x0 = std::max(clip.x0, 0);        clip.y0 = std::max(clip.y0, 0);
+    clip.x1 = std::min(clip.x1, g_width);  clip.y1 = std::min(clip.y1, g_height);
+    if (clip.empty())
+        return false;
+
+    ei::DnaBrush saved = poly.brush();
+    poly.setBrush(ei::DnaBrush(0, 0, 0, saved.a));
+    cairo_surface_t *black = renderDrawingOver(d, image, clip);
+    poly.setBrush(ei::DnaBrush(255, 255, 255, saved.a));
+    cairo_surface_t *white = renderDrawingOver(d, image, clip);
+    poly.setBrush(saved);
+    if (!black || !white)
+    {
+        cairo_surface_destroy(black);
+        cairo_surface_destroy(white);
+        return false;
+    }
+
+    const uint8_t *f0 = cairo_image_surface_get_data(black);
+    const uint8_t *f1 = cairo_image_surface_get_data(white);
+    int stride = cairo_image_surface_get_stride(black);
+    int ps = g_target.planeStride(ei::PlaneR);
+    const uint8_t *target[3] = { g_target.plane(ei::PlaneR), g_target.plane(ei::PlaneG),
+                                 g_target.plane(ei::PlaneB) };
+    int64_t num[3] = {0, 0, 0}, den[3] = {0, 0, 0};
+
+    for (int y = clip.y0; y < clip.y1; y++)
+    {
+        const uint8_t *row0 = f0 + y * stride, *row1 = f1 + y * stride;
+        for (int x = clip.x0; x < clip.x1; x++)
+        {
+            for (int c = 0; c < 3; c++)
+            {
+                int byte = x * 4 + 2 - c;   // BGRX
+                int k = row1[byte] - row0[byte];
+                num[c] += k * (target[c][y * ps + x] - row0[byte]);
+                den[c] += k * k;
+            }
+        }
+    }
+    cairo_surface_destroy(black);
+    cairo_surface_destroy(white);
+
+    // A channel that no pixel responds to (a nearly clear brush rounds
+    // away) keeps its color
+    int fit[3] = { saved.r, saved.g, saved.b };
+    bool any = false;
+    for (int c = 0; c < 3; c++)
+    {
+        if (den[c] == 0)
+            continue;
+        fit[c] = std::min(255, std::max(0, (int)((255 * num[c] + den[c] / 2) / den[c])));
+        any = true;
+    }
+    if (!any)
+        return false;
+    poly.setBrush(ei::DnaBrush(fit[0], fit[1], fit[2], saved.a));
+    return true;
+}
+
+/*
+ * Refit the colors of the polygons a child's mutations changed, and
+ * keep the refit if it scores better than the child as mutated.
+ */
+static void refitChild(DrawingInfo &info, ei::DnaRect const &clip,
+                       int tx0, int ty0, int tx1, int ty1)
+{
+    ei::DnaPolygonList &polys = info.drawing->polygons();
+    std::vector<ei::DnaBrush> saved;
+    bool refit = false;
+
+    for (int i = 0; i < (int)polys.size(); i++)
+    {
+        saved.push_back(polys[i].brush());
+        if (polys[i].changed())
+            refit = refitPolygonColor(info.drawing, i, info.image) || refit;
+    }
+    if (!refit)
+        return;
+
+    // changed polygons are inside the dirty rectangle, hence inside clip
+    ei::TileErrorMap errors = info.errors;
+    cairo_surface_t *image = renderDrawingOver(info.drawing, info.image, clip);
+    diffTiles(image, errors, tx0, ty0, tx1, ty1);
+    if (errors.total() < info.difference)
+    {
+        cairo_surface_destroy(info.image);
+        info.image = image;
+        info.errors = errors;
+        info.difference = errors.total();
+    }
+    else
+    {
+        cairo_surface_destroy(image);
+        for (int i = 0; i < (int)polys.size(); i++)
+            polys[i].setBrush(saved[i]);
+    }
+}
+
+/*
+ * Render and score a child of parent. Only the tiles under the child's
+ * dirty rectangle are redrawn and re-diffed; everything else is the
+ * parent's, so the cost follows the size of the change.
+ */
+static void evaluateChild(DrawingInfo &info, cairo_surface_t *parentImage,
+                          ei::TileErrorMap const &parentErrors, uint32_t parentDifference)
+{
+    ei::TraceScope trace("evaluate");
+    if (g_programArgs.fullEvaluation)
+    {
+        info.image = renderDrawing(info.drawing);
+        info.difference = diffImages(info.image);
+        return;
+    }
+
+    int tx0, ty0, tx1, ty1;
+    info.errors = parentErrors;
+    if (!parentErrors.tileSpan(info.drawing->dirtyRect(), tx0, ty0, tx1, ty1))
+    {
+        info.image = 0;                     // nothing visible changed
+        info.difference = parentDifference;
+        return;
+    }
+
+    ei::DnaRect clip = tileClip(tx0, ty0, tx1, ty1);
+    info.image = renderDrawingOver(info.drawing, parentImage, clip);
+    diffTiles(info.image, info.errors, tx0, ty0, tx1, ty1);
+    info.difference = info.errors.total();
+
+    if (g_programArgs.refitChildren)
+        refitChild(info, clip, tx0, ty0, tx1, ty1);
+}
+
 
 void usage()
 {
     std::cout << "usage: evoimage [options] environment.png\n"
+              << "       evoimage [options] --sequence frame.png...\n"
               << "Options:\n"
               << "    -r n    Render every n generations (default 300)\n"
               << "    -g n    Limit generations to n (default 10000)\n"
@@ -223,16 +490,212 @@ void usage()
               << "    -p n    Set maximum number of polygons used (default 50)\n"
               << "    -v n    Set maximum number of vertices/polygon used (default 20)\n"
               << "    -j file Save final image geometry as JSON 'file'\n"
+              << "    -e mode Evaluation mode: rgb (default), or ycc for\n"
+              << "            luma plus half-resolution chroma\n"
+              << "    --ycc-weights Y,C  Per-sample weights of luma and chroma\n"
+              << "            planes in ycc mode (default 1,1)\n"
+              << "    --target-cache dir  Keep prepared environment images in\n"
+              << "            'dir', and map them from there on later runs\n"
+              << "    --tile-size n  Edge of the error map tiles; children only\n"
+              << "            re-render and re-diff tiles they touch (default 16)\n"
+              << "    --full-eval  Render and diff every child in full\n"
+              << "    --guided pct  Place pct% of new polygons and large point\n"
+              << "            moves by the parent's per-tile error (default 0)\n"
+              << "    --refit  Give polygons a child changed their least-squares\n"
+              << "            best color before scoring it\n"
+              << "    --refit-every n  Refit every polygon color of the parent\n"
+              << "            every n generations\n"
+              << "    --polish-stall n  Run a local vertex/color search pass\n"
+              << "            when n generations pass without improvement\n"
+              << "    --polish-end n  Run up to n local search passes after\n"
+              << "            the last generation\n"
+              << "    --prune-every n  Every n generations and at the end, remove\n"
+              << "            polygons, and vertices nearly in line with their\n"
+              << "            neighbors, that the parent can do without\n"
+              << "    --prune-tolerance pct  ...letting each pass raise the\n"
+              << "            difference by up to pct% (default 0.1)\n"
+              << "    --adapt-rates n  Every n generations, re-weight the mutation\n"
+              << "            rates by how often each operator's children are kept\n"
+              << "    --adapt-bound f  Keep adapted rates within 1/f..f times\n"
+              << "            their configured value (default 4)\n"
+              << "    --op-stats file  Write per-operator mutation statistics to\n"
+              << "            'file': JSON if it ends in .json, CSV otherwise\n"
+              << "    --op-stats-every n  ...every n generations (default 2000)\n"
+              << "    --profile  Report time per phase, throughput and allocations\n"
+              << "            with each progress report, and in total at the end\n"
+              << "    --profile-file file  Also append the reports to 'file' as CSV\n"
+              << "    --trace file  Write a Chrome/Perfetto trace of the run to 'file'\n"
+              << "            (island --processes each write 'file'.island<n>)\n"
+              << "    --trace-events n  Keep the last n trace events per thread\n"
+              << "            (default 1048576)\n"
+              << "    --live-stats file  Keep the run's progress in 'file' for\n"
+              << "            monitors, e.g. /dev/shm/evoimage.stats (see evostat)\n"
+              << "    --progress file  Log seconds, generation and difference to\n"
+              << "            'file' as CSV whenever the difference drops\n"
+              << "    --islands k  Evolve k independent lineages on k threads,\n"
+              << "            keeping the best at the end (default: one, no threads)\n"
+              << "    --processes  Run the islands in forked worker processes that\n"
+              << "            share the environment and trade drawings in shared memory\n"
+              << "    --migrate-every n  Islands trade their best drawing every n\n"
+              << "            generations (default 500)\n"
+              << "    --topology ring|random  Take migrants from the previous\n"
+              << "            island (ring, the default) or a random one\n"
+              << "    --population mu  Evolve a (mu+lambda) population, lambda\n"
+              << "            being -c (up to 1000), instead of a single parent\n"
+              << "    --tournament k  Choose each parent as the best of k random\n"
+              << "            members of the population (default 2)\n"
+              << "    --crossover pct  Splice a range of a second parent's polygons\n"
+              << "            into pct% of the children (default 0)\n"
+              << "    --eval-threads n  Score a population's children on n threads\n"
+              << "            (default 1)\n"
+              << "    --anneal t0[,t1]  Simulated annealing: also take a child worse\n"
+              << "            by d with probability exp(-d / (t * difference)), t\n"
+              << "            cooling from t0 to t1 (default t0/1000) over the run\n"
+              << "    --threshold t0[,t1]  Threshold accepting: also take a child\n"
+              << "            worse by no more than t * difference\n"
+              << "    --cooling exp|linear  Schedule of t (default exp)\n"
+              << "    --deadline secs  Stop after secs of wall-clock time\n"
+              << "    --target-difference d  Stop once the difference is d or less\n"
+              << "    --plateau n[,pct]  Stop when n generations improved the\n"
+              << "            difference by less than pct% (default 0.1)\n"
+              << "    --restarts k  On the first k plateaus, restart from a\n"
+              << "            perturbed copy of the best drawing instead\n"
+              << "    --perturb n  Rounds of mutation per restart (default 10)\n"
+              << "    --polygon-cost d  Select on the difference plus d per polygon\n"
+              << "    --vertex-cost d  ...plus d per vertex\n"
+              << "    --area-budget f  Reject drawings whose polygons fill more than\n"
+              << "            f times the canvas in all, overdraw included\n"
+              << "    Stopping early still writes the final image and JSON.\n"
+              << "    --sequence  Evolve each frame given from the drawing of the\n"
+              << "            frame before it, writing mutations/frame-NNNNN.png\n"
+              << "            and .json per frame; -j is not used\n"
+              << "    --frame-generations n  Limit frames after the first to n\n"
+              << "            generations (default: -g); --plateau also applies\n"
+              << "    --pipeline  Load the next frame and write the last one on\n"
+              << "            background threads while a frame evolves\n"
+              << "    --split CxR  Evolve C x R regions of the canvas on a thread\n"
+              << "            each, with -p/(C*R) polygons apiece, for -g generations;\n"
+              << "            then merge them and evolve the whole\n"
+              << "    --split-overlap px  Let regions reach px pixels into their\n"
+              << "            neighbors (default 8)\n"
+              << "    --split-refine n  Generations of the merged drawing (default 1000)\n"
+              << "    --init mode[,n]  Start from random polygons (random, the\n"
+              << "            default), or seed n of them (default half of -p) with\n"
+              << "            the target's colors: a grid of cells, or kmeans regions\n"
               << std::endl
               << "The environment.png file must have a resolution of 200x200.\n";
     exit(1);
 }
 
+// Long-only options start past the range of single-character switches
+enum {
+    OPT_YCC_WEIGHTS = 256,
+    OPT_TARGET_CACHE,
+    OPT_TILE_SIZE,
+    OPT_FULL_EVAL,
+    OPT_GUIDED,
+    OPT_REFIT,
+    OPT_REFIT_EVERY,
+    OPT_POLISH_STALL,
+    OPT_POLISH_END,
+    OPT_PRUNE_EVERY,
+    OPT_PRUNE_TOLERANCE,
+    OPT_ADAPT_RATES,
+    OPT_ADAPT_BOUND,
+    OPT_OP_STATS,
+    OPT_OP_STATS_EVERY,
+    OPT_PROFILE,
+    OPT_PROFILE_FILE,
+    OPT_TRACE,
+    OPT_TRACE_EVENTS,
+    OPT_LIVE_STATS,
+    OPT_PROGRESS,
+    OPT_ISLANDS,
+    OPT_PROCESSES,
+    OPT_POPULATION,
+    OPT_TOURNAMENT,
+    OPT_CROSSOVER,
+    OPT_EVAL_THREADS,
+    OPT_ANNEAL,
+    OPT_THRESHOLD,
+    OPT_COOLING,
+    OPT_DEADLINE,
+    OPT_TARGET_DIFFERENCE,
+    OPT_PLATEAU,
+    OPT_RESTARTS,
+    OPT_PERTURB,
+    OPT_MIGRATE_EVERY,
+    OPT_TOPOLOGY,
+    OPT_SEQUENCE,
+    OPT_FRAME_GENERATIONS,
+    OPT_PIPELINE,
+    OPT_SPLIT,
+    OPT_SPLIT_OVERLAP,
+    OPT_SPLIT_REFINE,
+    OPT_INIT,
+    OPT_POLYGON_COST,
+    OPT_VERTEX_COST,
+    OPT_AREA_BUDGET
+};
+
+static struct option g_longOptions[] = {
+    {"eval",        required_argument, 0, 'e'},
+    {"ycc-weights", required_argument, 0, OPT_YCC_WEIGHTS},
+    {"target-cache", required_argument, 0, OPT_TARGET_CACHE},
+    {"tile-size",   required_argument, 0, OPT_TILE_SIZE},
+    {"full-eval",   no_argument,       0, OPT_FULL_EVAL},
+    {"guided",      required_argument, 0, OPT_GUIDED},
+    {"refit",       no_argument,       0, OPT_REFIT},
+    {"refit-every", required_argument, 0, OPT_REFIT_EVERY},
+    {"polish-stall", required_argument, 0, OPT_POLISH_STALL},
+    {"polish-end",  required_argument, 0, OPT_POLISH_END},
+    {"prune-every", required_argument, 0, OPT_PRUNE_EVERY},
+    {"prune-tolerance", required_argument, 0, OPT_PRUNE_TOLERANCE},
+    {"adapt-rates", required_argument, 0, OPT_ADAPT_RATES},
+    {"adapt-bound", required_argument, 0, OPT_ADAPT_BOUND},
+    {"op-stats",    required_argument, 0, OPT_OP_STATS},
+    {"op-stats-every", required_argument, 0, OPT_OP_STATS_EVERY},
+    {"profile",     no_argument,       0, OPT_PROFILE},
+    {"profile-file", required_argument, 0, OPT_PROFILE_FILE},
+    {"trace",       required_argument, 0, OPT_TRACE},
+    {"trace-events", required_argument, 0, OPT_TRACE_EVENTS},
+    {"live-stats",  required_argument, 0, OPT_LIVE_STATS},
+    {"progress",    required_argument, 0, OPT_PROGRESS},
+    {"islands",     required_argument, 0, OPT_ISLANDS},
+    {"processes",   no_argument,       0, OPT_PROCESSES},
+    {"population",  required_argument, 0, OPT_POPULATION},
+    {"tournament",  required_argument, 0, OPT_TOURNAMENT},
+    {"crossover",   required_argument, 0, OPT_CROSSOVER},
+    {"eval-threads", required_argument, 0, OPT_EVAL_THREADS},
+    {"anneal",      required_argument, 0, OPT_ANNEAL},
+    {"threshold",   required_argument, 0, OPT_THRESHOLD},
+    {"cooling",     required_argument, 0, OPT_COOLING},
+    {"deadline",    required_argument, 0, OPT_DEADLINE},
+    {"target-difference", required_argument, 0, OPT_TARGET_DIFFERENCE},
+    {"plateau",     required_argument, 0, OPT_PLATEAU},
+    {"restarts",    required_argument, 0, OPT_RESTARTS},
+    {"perturb",     required_argument, 0, OPT_PERTURB},
+    {"migrate-every", required_argument, 0, OPT_MIGRATE_EVERY},
+    {"topology",    required_argument, 0, OPT_TOPOLOGY},
+    {"sequence",    no_argument,       0, OPT_SEQUENCE},
+    {"frame-generations", required_argument, 0, OPT_FRAME_GENERATIONS},
+    {"pipeline",    no_argument,       0, OPT_PIPELINE},
+    {"split",       required_argument, 0, OPT_SPLIT},
+    {"split-overlap", required_argument, 0, OPT_SPLIT_OVERLAP},
+    {"split-refine", required_argument, 0, OPT_SPLIT_REFINE},
+    {"init",        required_argument, 0, OPT_INIT},
+    {"polygon-cost", required_argument, 0, OPT_POLYGON_COST},
+    {"vertex-cost", required_argument, 0, OPT_VERTEX_COST},
+    {"area-budget", required_argument, 0, OPT_AREA_BUDGET},
+    {0, 0, 0, 0}
+};
+
 void checkArgs(int argc, char *argv[])
 {
     int option;
-    int temp;
-    while (-1 != (option = getopt(argc, argv, "r:g:c:s:p:v:j:")) )
+    int temp, temp2;
+    while (-1 != (option = getopt_long(argc, argv, "r:g:c:s:p:v:j:e:",
+                                       g_longOptions, NULL)) )
     {
         switch (option)
         {
@@ -268,6 +731,7 @@ void checkArgs(int argc, char *argv[])
             }
             std::cout << "Seeding rand() with " << temp << std::endl;
             srand(temp);
+            g_programArgs.seed = temp;
             break;
           case 'p':
             if (1 != sscanf(optarg, "%d", &temp))
@@ -295,6 +759,357 @@ void checkArgs(int argc, char *argv[])
             g_programArgs.jsonFilename = optarg;
             break;
 
+          case 'e':
+            if (0 == strcmp(optarg, "rgb"))
+                g_programArgs.diffMode = ei::DiffRgb;
+            else if (0 == strcmp(optarg, "ycc"))
+                g_programArgs.diffMode = ei::DiffYcc;
+            else
+            {
+                std::cout << "invalid mode for -e\n";
+                usage();
+            }
+            break;
+          case OPT_YCC_WEIGHTS:
+            if (2 != sscanf(optarg, "%d,%d", &temp, &temp2) || temp < 0 || temp2 < 0)
+            {
+                std::cout << "invalid weights for --ycc-weights\n";
+                usage();
+            }
+            g_programArgs.lumaWeight = temp;
+            g_programArgs.chromaWeight = temp2;
+            break;
+          case OPT_TARGET_CACHE:
+            g_programArgs.targetCacheDir = optarg;
+            break;
+          case OPT_TILE_SIZE:
+            // even, so ycc chroma blocks never straddle two tiles
+            if (1 != sscanf(optarg, "%d", &temp) || temp < 2 || temp > 200 || (temp & 1))
+            {
+                std::cout << "invalid tile size for --tile-size\n";
+                usage();
+            }
+            g_programArgs.tileSize = temp;
+            break;
+          case OPT_FULL_EVAL:
+            g_programArgs.fullEvaluation = true;
+            break;
+          case OPT_GUIDED:
+            if (1 != sscanf(optarg, "%d", &temp) || temp < 0 || temp > 100)
+            {
+                std::cout << "invalid percentage for --guided\n";
+                usage();
+            }
+            g_programArgs.guidedPercent = temp;
+            break;
+          case OPT_REFIT:
+            g_programArgs.refitChildren = true;
+            break;
+          case OPT_REFIT_EVERY:
+            if (1 != sscanf(optarg, "%d", &temp) || temp < 0)
+            {
+                std::cout << "invalid number for --refit-every\n";
+                usage();
+            }
+            g_programArgs.refitEvery = temp;
+            break;
+          case OPT_POLISH_STALL:
+            if (1 != sscanf(optarg, "%d", &temp) || temp < 0)
+            {
+                std::cout << "invalid number for --polish-stall\n";
+                usage();
+            }
+            g_programArgs.polishStall = temp;
+            break;
+          case OPT_POLISH_END:
+            if (1 != sscanf(optarg, "%d", &temp) || temp < 0)
+            {
+                std::cout << "invalid number for --polish-end\n";
+                usage();
+            }
+            g_programArgs.polishEnd = temp;
+            break;
+          case OPT_PRUNE_EVERY:
+            if (1 != sscanf(optarg, "%d", &temp) || temp < 0)
+            {
+                std::cout << "invalid number for --prune-every\n";
+                usage();
+            }
+            g_programArgs.pruneEvery = temp;
+            break;
+          case OPT_PRUNE_TOLERANCE:
+            if (1 != sscanf(optarg, "%lf", &g_programArgs.pruneTolerance) ||
+                g_programArgs.pruneTolerance < 0)
+            {
+                std::cout << "invalid number for --prune-tolerance\n";
+                usage();
+            }
+            break;
+          case OPT_ADAPT_RATES:
+            if (1 != sscanf(optarg, "%d", &temp) || temp < 0)
+            {
+                std::cout << "invalid number for --adapt-rates\n";
+                usage();
+            }
+            g_programArgs.adaptEvery = temp;
+            break;
+          case OPT_ADAPT_BOUND:
+            if (1 != sscanf(optarg, "%d", &temp) || temp < 1)
+            {
+                std::cout << "invalid number for --adapt-bound\n";
+                usage();
+            }
+            g_programArgs.adaptBound = temp;
+            break;
+          case OPT_OP_STATS:
+            g_programArgs.opStatsFilename = optarg;
+            break;
+          case OPT_OP_STATS_EVERY:
+            if (1 != sscanf(optarg, "%d", &temp) || temp < 1)
+            {
+                std::cout << "invalid number for --op-stats-every\n";
+                usage();
+            }
+            g_programArgs.opStatsEvery = temp;
+            break;
+          case OPT_PROFILE:
+            g_programArgs.profile = true;
+            break;
+          case OPT_PROFILE_FILE:
+            g_programArgs.profile = true;
+            g_programArgs.profileFilename = optarg;
+            break;
+          case OPT_TRACE:
+            g_programArgs.traceFilename = optarg;
+            break;
+          case OPT_TRACE_EVENTS:
+            if (1 != sscanf(optarg, "%d", &temp) || temp < 1)
+            {
+                std::cout << "invalid number for --trace-events\n";
+                usage();
+            }
+            g_programArgs.traceEvents = temp;
+            break;
+          case OPT_LIVE_STATS:
+            g_programArgs.liveStatsFilename = optarg;
+            break;
+          case OPT_PROGRESS:
+            g_programArgs.progressFilename = optarg;
+            break;
+          case OPT_ISLANDS:
+            if (1 != sscanf(optarg, "%d", &temp) || temp < 1 || temp > 64)
+            {
+                std::cout << "invalid number for --islands (1..64)\n";
+                usage();
+            }
+            g_programArgs.islands = temp;
+            break;
+          case OPT_PROCESSES:
+            g_programArgs.islandProcesses = true;
+            break;
+          case OPT_POPULATION:
+            if (1 != sscanf(optarg, "%d", &temp) || temp < 1)
+            {
+                std::cout << "invalid number for --population\n";
+                usage();
+            }
+            g_programArgs.population = temp;
+            break;
+          case OPT_TOURNAMENT:
+            if (1 != sscanf(optarg, "%d", &temp) || temp < 1)
+            {
+                std::cout << "invalid number for --tournament\n";
+                usage();
+            }
+            g_programArgs.tournamentSize = temp;
+            break;
+          case OPT_CROSSOVER:
+            if (1 != sscanf(optarg, "%d", &temp) || temp < 0 || temp > 100)
+            {
+                std::cout << "invalid percentage for --crossover\n";
+                usage();
+            }
+            g_programArgs.crossoverPercent = temp;
+            break;
+          case OPT_EVAL_THREADS:
+            if (1 != sscanf(optarg, "%d", &temp) || temp < 1 || temp > 64)
+            {
+                std::cout << "invalid number for --eval-threads (1..64)\n";
+                usage();
+            }
+            g_programArgs.evalThreads = temp;
+            break;
+          case OPT_ANNEAL:
+          case OPT_THRESHOLD:
+          {
+            double start, end;
+            int n = sscanf(optarg, "%lf,%lf", &start, &end);
+            if (n < 1 || start <= 0 || (n == 2 && (end < 0 || end > start)))
+            {
+                std::cout << "invalid schedule for --anneal or --threshold (t0[,t1], t0 >= t1)\n";
+                usage();
+            }
+            g_programArgs.acceptance = option == OPT_ANNEAL ? AcceptAnneal : AcceptThreshold;
+            g_programArgs.acceptStart = start;
+            g_programArgs.acceptEnd = n == 2 ? end : start / 1000;
+            break;
+          }
+          case OPT_COOLING:
+            if (0 == strcmp(optarg, "exp"))
+                g_programArgs.cooling = ei::CoolExponential;
+            else if (0 == strcmp(optarg, "linear"))
+                g_programArgs.cooling = ei::CoolLinear;
+            else
+            {
+                std::cout << "--cooling must be exp or linear\n";
+                usage();
+            }
+            break;
+          case OPT_DEADLINE:
+            if (1 != sscanf(optarg, "%lf", &g_programArgs.deadline) || g_programArgs.deadline <= 0)
+            {
+                std::cout << "invalid number of seconds for --deadline\n";
+                usage();
+            }
+            break;
+          case OPT_TARGET_DIFFERENCE:
+            if (1 != sscanf(optarg, "%u", &g_programArgs.targetDifference))
+            {
+                std::cout << "invalid number for --target-difference\n";
+                usage();
+            }
+            break;
+          case OPT_PLATEAU:
+            if (sscanf(optarg, "%d,%lf", &g_programArgs.plateauWindow, &g_programArgs.plateauGain) < 1 ||
+                g_programArgs.plateauWindow < 1 || g_programArgs.plateauGain < 0)
+            {
+                std::cout << "invalid window for --plateau (n[,pct])\n";
+                usage();
+            }
+            break;
+          case OPT_RESTARTS:
+            if (1 != sscanf(optarg, "%d", &temp) || temp < 0)
+            {
+                std::cout << "invalid number for --restarts\n";
+                usage();
+            }
+            g_programArgs.restarts = temp;
+            break;
+          case OPT_PERTURB:
+            if (1 != sscanf(optarg, "%d", &temp) || temp < 1)
+            {
+                std::cout << "invalid number for --perturb\n";
+                usage();
+            }
+            g_programArgs.perturbRounds = temp;
+            break;
+          case OPT_MIGRATE_EVERY:
+            if (1 != sscanf(optarg, "%d", &temp) || temp < 1)
+            {
+                std::cout << "invalid number for --migrate-every\n";
+                usage();
+            }
+            g_programArgs.migrateEvery = temp;
+            break;
+          case OPT_TOPOLOGY:
+            if (0 == strcmp(optarg, "ring"))
+                g_programArgs.randomTopology = false;
+            else if (0 == strcmp(optarg, "random"))
+                g_programArgs.randomTopology = true;
+            else
+            {
+                std::cout << "--topology must be ring or random\n";
+                usage();
+            }
+            break;
+          case OPT_SEQUENCE:
+            g_programArgs.sequence = true;
+            break;
+          case OPT_FRAME_GENERATIONS:
+            if (1 != sscanf(optarg, "%d", &temp) || temp < 1)
+            {
+                std::cout << "invalid number for --frame-generations\n";
+                usage();
+            }
+            g_programArgs.frameGenerations = temp;
+            break;
+          case OPT_PIPELINE:
+            g_programArgs.pipeline = true;
+            break;
+          case OPT_SPLIT:
+            if (2 != sscanf(optarg, "%dx%d", &temp, &temp2) ||
+                temp < 1 || temp2 < 1 || temp * temp2 < 2 || temp > 16 || temp2 > 16)
+            {
+                std::cout << "--split must be CxR, for 2 to 256 regions of up to 16x16\n";
+                usage();
+            }
+            g_programArgs.splitColumns = temp;
+            g_programArgs.splitRows = temp2;
+            break;
+          case OPT_SPLIT_OVERLAP:
+            if (1 != sscanf(optarg, "%d", &temp) || temp < 0 || temp > g_width / 2)
+            {
+                std::cout << "invalid number for --split-overlap\n";
+                usage();
+            }
+            g_programArgs.splitOverlap = temp;
+            break;
+          case OPT_SPLIT_REFINE:
+            if (1 != sscanf(optarg, "%d", &temp) || temp < 0)
+            {
+                std::cout << "invalid number for --split-refine\n";
+                usage();
+            }
+            g_programArgs.splitRefine = temp;
+            break;
+          case OPT_INIT:
+          {
+            char mode[16];
+            temp = 0;
+            if (sscanf(optarg, "%15[^,],%d", mode, &temp) < 1 || temp < 0)
+            {
+                std::cout << "invalid --init\n";
+                usage();
+            }
+            if (0 == strcmp(mode, "random"))
+                g_programArgs.initMode = InitRandom;
+            else if (0 == strcmp(mode, "grid"))
+                g_programArgs.initMode = InitGrid;
+            else if (0 == strcmp(mode, "kmeans"))
+                g_programArgs.initMode = InitKmeans;
+            else
+            {
+                std::cout << "--init must be random, grid or kmeans\n";
+                usage();
+            }
+            g_programArgs.initPolygons = temp;
+            break;
+          }
+          case OPT_POLYGON_COST:
+            if (1 != sscanf(optarg, "%d", &temp) || temp < 0)
+            {
+                std::cout << "invalid number for --polygon-cost\n";
+                usage();
+            }
+            g_programArgs.polygonCost = temp;
+            break;
+          case OPT_VERTEX_COST:
+            if (1 != sscanf(optarg, "%d", &temp) || temp < 0)
+            {
+                std::cout << "invalid number for --vertex-cost\n";
+                usage();
+            }
+            g_programArgs.vertexCost = temp;
+            break;
+          case OPT_AREA_BUDGET:
+            if (1 != sscanf(optarg, "%lf", &g_programArgs.areaBudget) ||
+                g_programArgs.areaBudget <= 0)
+            {
+                std::cout << "invalid number for --area-budget\n";
+                usage();
+            }
+            break;
+
           default:
             std::cout << "unrecognized switch " << (char)option << std::endl;
           case 'h':
@@ -305,7 +1120,12 @@ void checkArgs(int argc, char *argv[])
     argc -= optind;
     argv += optind;
 
-    if (argc == 1)                      // get environment filename
+    if (g_programArgs.sequence && argc >= 1) // every argument is a frame
+    {
+        g_programArgs.frames.assign(argv, argv + argc);
+        g_programArgs.environmentFilename = argv[0];
+    }
+    else if (argc == 1)                 // get environment filename
     {
         g_programArgs.environmentFilename = argv[0];
     }
@@ -316,40 +1136,302 @@ void checkArgs(int argc, char *argv[])
     }
     // Sanity check arguments
     if (g_programArgs.renderImageEvery < 1 ||
-        g_programArgs.numberOfChildren < 1 || g_programArgs.numberOfChildren > 10 ||
+        g_programArgs.numberOfChildren < 1 ||
+        g_programArgs.numberOfChildren > (g_programArgs.population > 0 ? 1000 : 10) ||
         g_programArgs.generationLimit < 1
         )
     {
         std::cout << "Invalid values for some arguments given.\n";
         usage();
     }
+    if ((g_programArgs.guidedPercent > 0 || g_programArgs.refitChildren ||
+         g_programArgs.refitEvery > 0 || g_programArgs.polishStall > 0 ||
+         g_programArgs.polishEnd > 0 || g_programArgs.pruneEvery > 0) && g_programArgs.fullEvaluation)
+    {
+        std::cout << "--guided, --refit, --polish and --prune need the tile error map, which --full-eval does not keep\n";
+        usage();
+    }
+    if (g_programArgs.islandProcesses && 0 == g_programArgs.islands)
+    {
+        std::cout << "--processes needs --islands\n";
+        usage();
+    }
+    if (g_programArgs.islands > 0 && (g_programArgs.adaptEvery > 0 || g_programArgs.profile))
+    {
+        std::cout << "--adapt-rates and --profile work on a single lineage, not with --islands\n";
+        usage();
+    }
+    if (g_programArgs.population > 0 &&
+        (g_programArgs.islands > 0 || g_programArgs.refitEvery > 0 || g_programArgs.polishStall > 0 ||
+         g_programArgs.pruneEvery > 0))
+    {
+        std::cout << "--population does not combine with --islands, --refit-every, --polish-stall or --prune-every\n";
+        usage();
+    }
+    if (g_programArgs.population > 0 && g_programArgs.acceptance != AcceptGreedy)
+    {
+        std::cout << "--anneal and --threshold choose a single parent's successor, not with --population\n";
+        usage();
+    }
+    if (g_programArgs.population == 0 &&
+        (g_programArgs.evalThreads > 1 || g_programArgs.crossoverPercent > 0))
+    {
+        std::cout << "--eval-threads and --crossover need --population\n";
+        usage();
+    }
+    if (g_programArgs.evalThreads > 1 && g_programArgs.profile)
+    {
+        std::cout << "--profile times the main thread only, not with --eval-threads\n";
+        usage();
+    }
+    if (!g_programArgs.sequence && (g_programArgs.frameGenerations > 0 || g_programArgs.pipeline))
+    {
+        std::cout << "--frame-generations and --pipeline need --sequence\n";
+        usage();
+    }
+    if (g_programArgs.sequence && g_programArgs.islands > 0)
+    {
+        std::cout << "--sequence evolves a single lineage per frame, not with --islands\n";
+        usage();
+    }
+    if (g_programArgs.splitColumns > 0 &&
+        (g_programArgs.islands > 0 || g_programArgs.population > 0 || g_programArgs.sequence ||
+         g_programArgs.guidedPercent > 0 || g_programArgs.adaptEvery > 0 || g_programArgs.profile))
+    {
+        std::cout << "--split does not combine with --islands, --population, --sequence,\n"
+                  << "--guided, --adapt-rates or --profile\n";
+        usage();
+    }
+    if (g_programArgs.splitColumns > 0 &&
+        g_programArgs.polygonsMax / (g_programArgs.splitColumns * g_programArgs.splitRows) <
+        ei::Settings::activePolygonsMin)
+    {
+        std::cout << "-p leaves fewer than " << ei::Settings::activePolygonsMin
+                  << " polygons per --split region\n";
+        usage();
+    }
+    if (g_programArgs.splitColumns > 0 &&
+        ei::Settings::activePointsMax / (g_programArgs.splitColumns * g_programArgs.splitRows) <
+        ei::Settings::activePolygonsMin * ei::Settings::activePointsPerPolygonMin)
+    {
+        std::cout << "the drawing's " << ei::Settings::activePointsMax << " points leave fewer than "
+                  << ei::Settings::activePolygonsMin * ei::Settings::activePointsPerPolygonMin
+                  << " per --split region\n";
+        usage();
+    }
+    if (g_programArgs.splitColumns > 0 && g_programArgs.areaBudget > 0)
+    {
+        std::cout << "--area-budget covers the whole canvas, not --split regions\n";
+        usage();
+    }
 }
 
-static int loadEnvironmentPng()
+/*
+ * Rebuild an environment surface from the target's planes, for when
+ * the target was mapped from the cache instead of decoded.
+ */
+static cairo_surface_t *surfaceFromTarget(ei::TargetImage const &target)
+{
+    cairo_surface_t *surface = cairo_image_surface_create(CAIRO_FORMAT_RGB24,
+                                                          target.width(),
+                                                          target.height());
+    if (cairo_surface_status(surface) != CAIRO_STATUS_SUCCESS)
+        return surface;
+
+    uint8_t *data = cairo_image_surface_get_data(surface);
+    int stride = cairo_image_surface_get_stride(surface);
+    int ps = target.planeStride(ei::PlaneR);
+    for (int y = 0; y < target.height(); y++)
+    {
+        const uint8_t *r = target.plane(ei::PlaneR) + y * ps;
+        const uint8_t *g = target.plane(ei::PlaneG) + y * ps;
+        const uint8_t *b = target.plane(ei::PlaneB) + y * ps;
+        uint8_t *row = data + y * stride;
+        for (int x = 0; x < target.width(); x++)
+        {
+            row[x*4 + 0] = b[x];
+            row[x*4 + 1] = g[x];
+            row[x*4 + 2] = r[x];
+            row[x*4 + 3] = 0xff;
+        }
+    }
+    cairo_surface_mark_dirty(surface);
+    return surface;
+}
+
+/*
+ * Decode and prepare the image in filename (or map it from the target
+ * cache) into target, and give its pixels as surface.
+ */
+static int loadTarget(const char *filename, ei::TargetImage &target, cairo_surface_t *&surface)
 {
+    ei::TargetCache cache(g_programArgs.targetCacheDir);
+    std::string cacheEntry;
+
+    // A prepared copy of this exact file may already be cached
+    if (g_programArgs.targetCacheDir.length())
+    {
+        cacheEntry = cache.entryFor(filename, g_width, g_height, g_programArgs.tileSize);
+        if (cacheEntry.length() && cache.load(cacheEntry, target))
+        {
+            std::cout << "Mapped prepared environment " << cacheEntry << std::endl;
+            target.setYccWeights(g_programArgs.lumaWeight, g_programArgs.chromaWeight);
+            surface = surfaceFromTarget(target);
+            return 1;
+        }
+    }
+
     // Load environment image and perform sanity checks
-    g_environmentImage = cairo_image_surface_create_from_png(g_programArgs.environmentFilename);
-    if (cairo_surface_status(g_environmentImage) != CAIRO_STATUS_SUCCESS)
+    surface = cairo_image_surface_create_from_png(filename);
+    if (cairo_surface_status(surface) != CAIRO_STATUS_SUCCESS)
+    {
+        std::cout << "Could not open " << filename << std::endl;
+        return 0;
+    }
+
+    if (cairo_image_surface_get_width(surface) < g_width ||
+        cairo_image_surface_get_height(surface) < g_height)
+    {
+        std::cout << filename << " must be at least "
+                  << g_width << 'x' << g_height << std::endl;
+        return 0;
+    }
+
+    // Prepare once; children are compared against these planes, and
+    // evaluators only ever read them.
+    if (!target.load(cairo_image_surface_get_data(surface),
+                     g_width, g_height,
+                     cairo_image_surface_get_stride(surface),
+                     g_programArgs.tileSize))
     {
-        std::cout << "Could not open " << g_programArgs.environmentFilename << std::endl;
+        std::cout << "Could not prepare " << filename << std::endl;
         return 0;
     }
+    target.setYccWeights(g_programArgs.lumaWeight, g_programArgs.chromaWeight);
+
+    if (cacheEntry.length())
+    {
+        if (cache.store(cacheEntry, target))
+            std::cout << "Cached prepared environment " << cacheEntry << std::endl;
+        else
+            std::cout << "warning: could not write " << cacheEntry << std::endl;
+    }
 
     return 1;
 }
 
+static int loadEnvironmentPng()
+{
+    return loadTarget(g_programArgs.environmentFilename, g_target, g_environmentImage);
+}
+
+/*
+ * What selection compares: the difference of drawing d, plus its
+ * complexity penalty when --polygon-cost and the like ask for one
+ */
+static uint32_t fitness(ei::DnaDrawing *d, uint32_t difference)
+{
+    return g_complexity.enabled() ? g_complexity.score(*d, difference) : difference;
+}
+
+/*
+ * Under a policy that may take worse children, or when plateaus
+ * restart the lineage, keep a copy of the parent whenever it is the
+ * best drawing this lineage has seen.
+ */
+static void noteBest()
+{
+    bool mayLoseBest = !g_acceptance->monotone() || g_programArgs.restarts > 0;
+    if (!mayLoseBest)
+        return;
+    uint32_t lastFitness = fitness(g_lastDrawing, g_lastDifference);
+    if (g_bestDrawing && lastFitness >= g_bestFitness)
+        return;
+    delete g_bestDrawing;
+    g_bestDrawing = g_lastDrawing->clone();
+    g_bestDifference = g_lastDifference;
+    g_bestFitness = lastFitness;
+}
+
+/*
+ * The fitness of the best drawing of this lineage so far
+ */
+static uint32_t bestFitness()
+{
+    uint32_t lastFitness = fitness(g_lastDrawing, g_lastDifference);
+    return g_bestDrawing ? std::min(g_bestFitness, lastFitness) : lastFitness;
+}
+
+/*
+ * ...and its difference
+ */
+static uint32_t bestDifference()
+{
+    if (g_bestDrawing && g_bestFitness < fitness(g_lastDrawing, g_lastDifference))
+        return g_bestDifference;
+    return g_lastDifference;
+}
+
+static void startLineage(ei::DnaDrawing *d);
+
+/*
+ * Make the best drawing seen the parent again, at the end of a run
+ */
+static void restoreBest()
+{
+    ei::DnaDrawing *best = g_bestDrawing;
+    g_bestDrawing = 0;
+    if (best && g_bestFitness < fitness(g_lastDrawing, g_lastDifference))
+        startLineage(best);
+    else
+        delete best;
+}
+
+/*
+ * Make d (which is taken over) this thread's parent: render it in full
+ * and diff every tile. Any previous parent is freed.
+ */
+static void startLineage(ei::DnaDrawing *d)
+{
+    delete g_lastDrawing;
+    cairo_surface_destroy(g_lastImage);
+
+    g_lastDrawing = d;
+    g_lastImage = renderDrawing(g_lastDrawing);
+    g_lastDifference = diffImages(g_lastImage);
+
+    g_lastErrors.reset(g_width, g_height, g_programArgs.tileSize);
+    diffTiles(g_lastImage, g_lastErrors, 0, 0, g_lastErrors.tilesX(), g_lastErrors.tilesY());
+    if (g_guidedSampler)
+        g_guidedSampler->update(g_lastErrors);
+    noteBest();
+}
+
+/*
+ * A first drawing over area: random, or seeded from the target by --init
+ */
+static ei::DnaDrawing *newDrawing(ei::DnaRect const &area)
+{
+    int polygons = g_programArgs.initPolygons > 0 ?
+        g_programArgs.initPolygons : ei::Settings::activePolygonsMax / 2;
+    if (g_programArgs.initMode == InitGrid)
+        return ei::Initializer::grid(g_target, area, polygons);
+    if (g_programArgs.initMode == InitKmeans)
+        return ei::Initializer::kmeans(g_target, area, polygons);
+
+    ei::DnaDrawing *drawing = new ei::DnaDrawing();
+    drawing->init();
+    return drawing;
+}
+
 static void generateFirstDrawing()
 {
     // Generate 1st Drawing. Calc difference. Save image&diff as "last".
-    g_lastDrawing = new ei::DnaDrawing();
-    g_lastDrawing->init();
-    cairo_surface_t *tempImage = renderDrawing(g_lastDrawing);
-    g_lastDifference = diffImages(g_environmentImage, tempImage);
+    startLineage(newDrawing(ei::DnaRect(0, 0, g_width, g_height)));
 
     renderImageFile(g_environmentImage, 0);     // save environment as 0
-    renderImageFile(tempImage, 1);       // always save off first specimen as 1
+    renderImageFile(g_lastImage, 1);     // always save off first specimen as 1
     std::cout << "Initial difference = " << g_lastDifference << std::endl;
-    cairo_surface_destroy(tempImage);
 }
 
 static void generateLastDrawing()
@@ -359,206 +1441,1749 @@ static void generateLastDrawing()
     cairo_surface_destroy(tempImage);
 }
 
-static void doNextMutation()
+/*
+ * g_lastDrawing was just edited in place, inside dirty. Re-render and
+ * re-diff those tiles; if the parent got better (or worse by no more
+ * than tolerance, when one is given), keep the edit (the rendering, map
+ * and difference follow it) and return true. Otherwise the parent's
+ * state is untouched and the caller must undo the edit.
+ */
+static bool tryParentEdit(ei::DnaRect const &dirty, int64_t tolerance = -1)
 {
-    static int nextRenderedImage = 0;
-
-    // Mutation algorithm
-    if (g_generationCount <= g_programArgs.generationLimit)
+    int tx0, ty0, tx1, ty1;
+    ei::TileErrorMap errors = g_lastErrors;
+    if (!errors.tileSpan(dirty, tx0, ty0, tx1, ty1))
+        return false;
+
+    cairo_surface_t *image = renderDrawingOver(g_lastDrawing, g_lastImage,
+                                               tileClip(tx0, ty0, tx1, ty1));
+    diffTiles(image, errors, tx0, ty0, tx1, ty1);
+    if ((int64_t)errors.total() > (int64_t)g_lastDifference + tolerance)
     {
-        // Periodically report current convergence
-        if (0 == g_generationCount % 2000)
-        {
-            std::cout << "Current difference is " << g_lastDifference 
-                      << " at generation " << g_generationCount << ". "
-                      << g_lastDrawing->polygons().size() << " polys, "
-                      << g_lastDrawing->pointCount() << " points"
-                      << std::endl;
-        }
+        cairo_surface_destroy(image);
+        return false;
+    }
 
-        // 1. Clone last drawing and mutate.
-        typedef struct {
-            ei::DnaDrawing  *drawing;
-            cairo_surface_t *image;
-        } DrawingInfo;
+    cairo_surface_destroy(g_lastImage);
+    g_lastImage = image;
+    g_lastErrors = errors;
+    g_lastDifference = errors.total();
+    return true;
+}
 
-        DrawingInfo children[g_programArgs.numberOfChildren];
+/*
+ * Refit the color of every polygon of the parent in turn, keeping each
+ * refit that lowers the difference. Returns the number kept.
+ */
+static int refitParent()
+{
+    ei::TraceScope trace("refit");
+    ei::DnaPolygonList &polys = g_lastDrawing->polygons();
+    int kept = 0;
 
-        int child;                          // looping index
-        int minChild;                       // child with minimal difference
-        uint32_t newDifference;
+    for (int i = 0; i < (int)polys.size(); i++)
+    {
+        ei::DnaBrush saved = polys[i].brush();
+        if (!refitPolygonColor(g_lastDrawing, i, g_lastImage))
+            continue;
+
+        if (tryParentEdit(polys[i].bounds()))
+            kept++;
+        else
+            polys[i].setBrush(saved);
+    }
 
-        for (child=0; child < g_programArgs.numberOfChildren; child++)
-        {
-            children[child].drawing = g_lastDrawing->clone();
-            children[child].drawing->mutate();
+    if (kept && g_guidedSampler)
+        g_guidedSampler->update(g_lastErrors);
+    return kept;
+}
 
-            // 2. Calc difference between child and environment.
-            children[child].image = renderDrawing(children[child].drawing);
-            uint32_t difference = diffImages(g_environmentImage, children[child].image);
+/*
+ * One deterministic local search pass over the parent. Each vertex is
+ * moved along x and y, and each brush channel up and down, by shrinking
+ * steps; a move is kept while it lowers the difference. Only the tiles
+ * under the polygon (before and after the move) are re-rendered.
+ * Returns the number of moves kept.
+ */
+static int polishParent()
+{
+    ei::TraceScope trace("polish");
+    static const int pointSteps[] = {8, 4, 2, 1};
+    static const int brushSteps[] = {16, 4, 1};
+    ei::DnaPolygonList &polys = g_lastDrawing->polygons();
+    int kept = 0;
 
-            // Locate child with the best fit to environment (smallest difference)
-            if (child == 0)
+    for (int i = 0; i < (int)polys.size(); i++)
+    {
+        ei::DnaPolygon &poly = polys[i];
+        ei::DnaPointList &points = poly.points();
+
+        for (int j = 0; j < (int)points.size(); j++)
+        {
+            for (int s = 0; s < 4; s++)
             {
-                newDifference = difference;
-                minChild = 0;
+                bool improved = true;
+                while (improved)
+                {
+                    static const int dirs[4][2] = {{1, 0}, {-1, 0}, {0, 1}, {0, -1}};
+                    improved = false;
+                    for (int d = 0; d < 4 && !improved; d++)
+                    {
+                        ei::DnaPoint saved = points[j];
+                        ei::DnaRect dirty = poly.bounds();
+                        points[j].x = saved.x + dirs[d][0] * pointSteps[s];
+                        points[j].y = saved.y + dirs[d][1] * pointSteps[s];
+                        ei::Tools::clampPosition(points[j].x, points[j].y);
+                        if (points[j].x == saved.x && points[j].y == saved.y)
+                            continue;
+                        if (g_complexity.overBudget(*g_lastDrawing))
+                        {
+                            points[j] = saved;
+                            continue;
+                        }
+
+                        dirty.unite(poly.bounds());
+                        if (tryParentEdit(dirty))
+                            improved = true;
+                        else
+                            points[j] = saved;
+                    }
+                    kept += improved;
+                }
             }
-            else
+        }
+
+        for (int c = 0; c < 4; c++)
+        {
+            for (int s = 0; s < 3; s++)
             {
-                if (difference < newDifference) // found new min
+                bool improved = true;
+                while (improved)
                 {
-                    minChild = child;
-                    newDifference = difference;
+                    improved = false;
+                    for (int sign = 1; sign >= -1 && !improved; sign -= 2)
+                    {
+                        ei::DnaBrush saved = poly.brush();
+                        int before[4] = { saved.r, saved.g, saved.b, saved.a };
+                        int *channel[4] = { &poly.brush().r, &poly.brush().g,
+                                            &poly.brush().b, &poly.brush().a };
+                        *channel[c] = std::min(255, std::max(0, before[c] + sign * brushSteps[s]));
+                        if (*channel[c] == before[c])
+                            continue;
+
+                        if (tryParentEdit(poly.bounds()))
+                            improved = true;
+                        else
+                            poly.setBrush(saved);
+                    }
+                    kept += improved;
                 }
             }
         }
+    }
 
-        // 3. If a child's difference is less than last difference, then save it
-        if (newDifference < g_lastDifference)
-        {
-            // 3.1 free last image
-            delete g_lastDrawing;
+    if (kept && g_guidedSampler)
+        g_guidedSampler->update(g_lastErrors);
+    return kept;
+}
 
-            // 3.2 save newDrwg&diff as "last"
-            g_lastDrawing = children[minChild].drawing;
-            g_lastDifference = newDifference;
-            children[minChild].drawing = 0;
+/*
+ * Remove what the parent can do without: each polygon (front to back),
+ * then each vertex within collinearDistance pixels of the line through
+ * its neighbors. A removal is kept while the pass has raised the
+ * difference by no more than --prune-tolerance percent in all, besides
+ * what removals save in complexity penalty; removals stop at the
+ * minimum polygon and point counts. Returns the number of polygons and
+ * vertices removed.
+ */
+static int pruneParent()
+{
+    ei::TraceScope trace("prune");
+    static const int collinearDistance = 2;
+    ei::DnaPolygonList &polys = g_lastDrawing->polygons();
+    int64_t allowed = g_lastDifference + (int64_t)(g_lastDifference * g_programArgs.pruneTolerance / 100);
+    int removed = 0;
 
-            // 3.3 render image to file named by iteration
-            // but limit it to sparse changes.
-            if (g_generationCount > nextRenderedImage)
-            {
-                renderImageFile(children[minChild].image, g_generationCount);
-                // if every = 100, then next after 171 is (171/100 + 1)*100 = 200
-                nextRenderedImage = ( (g_generationCount / g_programArgs.renderImageEvery + 1) *
-                                      g_programArgs.renderImageEvery);
-            } // time to render an image
-        } // new difference is lower
+    for (int i = (int)polys.size() - 1; i >= 0; i--)
+    {
+        if ((int)polys.size() <= ei::Settings::activePolygonsMin)
+            break;
+        ei::DnaPolygon saved = polys[i];
+        int64_t cost = fitness(g_lastDrawing, 0);
+        polys.erase(polys.begin() + i);
+        cost -= fitness(g_lastDrawing, 0);
+        if (tryParentEdit(saved.bounds(), allowed - g_lastDifference + cost))
+            removed++;
+        else
+            polys.insert(polys.begin() + i, saved);
+    }
 
-        // 4 clean up this iteration. If a child improved the
-        // drawing, it's pointer will be 0 already. Delete all
-        // DnaDrawings and gdImagePtrs.
-        for (child=0; child < g_programArgs.numberOfChildren; child++)
+    int points = g_lastDrawing->pointCount();
+    for (int i = 0; i < (int)polys.size(); i++)
+    {
+        ei::DnaPolygon &poly = polys[i];
+        ei::DnaPointList &pts = poly.points();
+        for (int j = 0; j < (int)pts.size(); j++)
         {
-            delete children[child].drawing;
-            cairo_surface_destroy(children[child].image);
+            if ((int)pts.size() <= ei::Settings::activePointsPerPolygonMin ||
+                points <= ei::Settings::activePointsMin)
+                break;
+
+            ei::DnaPoint const &a = pts[(j + pts.size() - 1) % pts.size()];
+            ei::DnaPoint const &b = pts[(j + 1) % pts.size()];
+            int64_t cross = (int64_t)(b.x - a.x) * (pts[j].y - a.y) - (int64_t)(b.y - a.y) * (pts[j].x - a.x);
+            int64_t length = (int64_t)(b.x - a.x) * (b.x - a.x) + (int64_t)(b.y - a.y) * (b.y - a.y);
+            if (cross * cross > collinearDistance * collinearDistance * length)
+                continue;
+
+            ei::DnaRect dirty = poly.bounds();
+            ei::DnaPoint saved = pts[j];
+            int64_t cost = fitness(g_lastDrawing, 0);
+            pts.erase(pts.begin() + j);
+            cost -= fitness(g_lastDrawing, 0);
+            if (tryParentEdit(dirty, allowed - g_lastDifference + cost))
+            {
+                removed++;
+                points--;
+                j--;
+            }
+            else
+                pts.insert(pts.begin() + j, saved);
         }
     }
+
+    if (removed && g_guidedSampler)
+        g_guidedSampler->update(g_lastErrors);
+    return removed;
 }
 
 /*
- * Write out drawing's polygons in JSON, if a filename was given.
+ * Print one line of profile totals, and append it to the profile file.
  */
-void saveDrawingJson(ei::DnaDrawing *drawing)
+static void printProfile(const char *scope, ei::PhaseProfiler::Totals const &t)
 {
-    if (0 == g_programArgs.jsonFilename.length())
+    static bool started = false;
+    double seconds = std::max(t.seconds, 1e-9);
+    uint64_t phaseNs = 0;
+    for (int i = 0; i < ei::PhaseCount; i++)
+        phaseNs += t.ns[i];
+
+    std::cout << "    " << scope << ": " << t.generations << " gens in " << t.seconds << " s, "
+              << uint64_t(t.generations / seconds) << " gens/s, "
+              << uint64_t(t.children / seconds) << " children/s, "
+              << (100.0 * t.accepted / std::max<uint64_t>(1, t.generations)) << "% accepted, "
+              << t.allocations << " allocations\n       ";
+    for (int i = 0; i < ei::PhaseCount; i++)
+        std::cout << ' ' << ei::profilePhaseName(ei::ProfilePhase(i)) << ' '
+                  << (t.ns[i] / 1e7 / seconds) << '%';
+    std::cout << " other " << std::max(0.0, 100.0 - phaseNs / 1e7 / seconds) << '%' << std::endl;
+
+    if (0 == g_programArgs.profileFilename.length())
         return;
 
-    std::ofstream outfile(g_programArgs.jsonFilename);
+    std::ofstream outfile(g_programArgs.profileFilename,
+                          started ? std::ios::app : std::ios::trunc);
     if (!outfile.is_open())
     {
-        std::cout << "Cannot open JSON output file "
-                  << g_programArgs.jsonFilename << std::endl;
+        std::cout << "Cannot open profile file " << g_programArgs.profileFilename << std::endl;
         return;
     }
-
-    /*
-     * Convert to JSON with this representation:
-     * * A drawing contains an array of polygons
-     * * A polygon has a color, and an array of points
-     * * A color is R,G,B,A values as doubles [0,1]
-     * * A point is X,Y coordinates as doubles [0,1]
-     */
-    Json::Value drwg;
-    Json::Value polygons(Json::arrayValue);
-    for (auto dnapoly: drawing->polygons())
+    if (!started)
     {
-        Json::Value color;
-        color["r"] = dnapoly.brush().r / 255.0;
-        color["g"] = dnapoly.brush().g / 255.0;
-        color["b"] = dnapoly.brush().b / 255.0;
-        color["a"] = dnapoly.brush().a / 255.0;
+        outfile << "scope,generation,seconds,generations,children,accepted,allocations";
+        for (int i = 0; i < ei::PhaseCount; i++)
+            outfile << ',' << ei::profilePhaseName(ei::ProfilePhase(i)) << "_ns";
+        outfile << '\n';
+        started = true;
+    }
+    outfile << scope << ',' << std::min(g_generationCount, g_programArgs.generationLimit) << ','
+            << t.seconds << ',' << t.generations << ',' << t.children << ','
+            << t.accepted << ',' << t.allocations;
+    for (int i = 0; i < ei::PhaseCount; i++)
+        outfile << ',' << t.ns[i];
+    outfile << '\n';
+}
 
-        Json::Value points(Json::arrayValue);
-        for (auto dnapoint: dnapoly.points())
-        {
-            Json::Value ptval;
-            ptval["x"] = dnapoint.x / 200.0;
-            ptval["y"] = dnapoint.y / 200.0;
-            points.append(ptval);
-        }
+static void reportProfile()
+{
+    g_profiler->endInterval(ei::AllocationCounter::count());
+    printProfile("interval", g_profiler->interval());
+    printProfile("total", g_profiler->total());
+}
+
+/*
+ * Copy the run's state to the live stats page. Cheap enough to call
+ * every generation; rates are refreshed about once a second.
+ */
+static void publishLiveStats(ei::LiveState state)
+{
+    static std::chrono::steady_clock::time_point rateStart = std::chrono::steady_clock::now();
+    static int rateGeneration = 0;
 
-        Json::Value polygon;
-        polygon["color"] = color;
-        polygon["points"] = points;
+    if (!g_liveStats.isOpen())
+        return;
 
-        polygons.append(polygon);
+    ei::LiveStatsData &data = g_liveStats.data();
+    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    double seconds = std::chrono::duration<double>(now - rateStart).count();
+    if (seconds >= 1.0 || state != ei::LiveRunning)
+    {
+        data.gensPerSecond = (g_generationCount - rateGeneration) / std::max(seconds, 1e-9);
+        data.childrenPerSecond = data.gensPerSecond * g_programArgs.numberOfChildren;
+        rateStart = now;
+        rateGeneration = g_generationCount;
     }
-    drwg["polygons"] = polygons;
-
-    // write it out and close the file
-    Json::StreamWriterBuilder builder;
-    builder["indentation"] = "    ";
-    std::unique_ptr<Json::StreamWriter> writer( builder.newStreamWriter() );
-    writer->write(drwg, &outfile);
-    outfile.close();
-    std::cout << "Wrote drawing to JSON file "
-              << g_programArgs.jsonFilename << std::endl;
 
-    return;
+    data.generation = std::min(g_generationCount, g_programArgs.generationLimit);
+    data.generationLimit = g_programArgs.generationLimit;
+    data.difference = bestDifference();
+    if (g_lastDrawing)                      // else the island monitor fills them in
+    {
+        data.polygons = g_lastDrawing->polygons().size();
+        data.points = g_lastDrawing->pointCount();
+    }
+    data.state = state;
+    data.lastImprovement = g_lastImprovement;
+    data.updated = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    if (g_profiler)
+    {
+        for (int i = 0; i < ei::PhaseCount; i++)
+            data.phaseNs[i] = g_profiler->total().ns[i] + g_profiler->current().ns[i];
+    }
+    g_liveStats.publish();
 }
 
-int main(int argc, char *argv[])
+/*
+ * Append a progress record if the difference dropped since the last
+ * one (or always, if force). Seconds count from process start, so
+ * loading the environment is part of the time to quality.
+ */
+static void logProgress(bool force)
 {
-    int nextRenderedImage = 0;
-
-    checkArgs(argc, argv);
-    std::cout << "Settings:\n"
-              << "    rendering image every ~"
-              << g_programArgs.renderImageEvery << std::endl
-              << "    children/generation: "
-              << g_programArgs.numberOfChildren << std::endl
-              << "    number of generations: "
-              << g_programArgs.generationLimit << std::endl
-              << "    environment image: "
-              << g_programArgs.environmentFilename << std::endl
-              << "    max polygons: "
-              << g_programArgs.polygonsMax << std::endl
-              << "    max points/poly: "
-              << g_programArgs.pointsMax << std::endl;
-
-    ei::Settings settings;
-    settings.setPolygonsMax(g_programArgs.polygonsMax);
-    settings.setPointsPerPolygonMax(g_programArgs.pointsMax);
-    settings.activate();
+    static uint32_t lastDifference = 0;
 
-    // Iterate the generations
-    if (!loadEnvironmentPng())
-        exit(0);
+    uint32_t difference = bestDifference();
+    if (!g_progressFile || (!force && difference == lastDifference))
+        return;
 
-    g_startTime = time(NULL);
-    while (g_generationCount <= g_programArgs.generationLimit) {
-        if (g_generationCount == 0)
-        {
-            g_startTime = time(NULL);
-            generateFirstDrawing();
-        }
-        else // all other increments
-        {
-            doNextMutation();
-        }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                                   g_processStart).count();
+    fprintf(g_progressFile, "%.6f,%d,%u\n", seconds,
+            std::min(g_generationCount, g_programArgs.generationLimit), difference);
+    lastDifference = difference;
+}
 
-        ++g_generationCount;
+/*
+ * Print how far the parent has come, where its difference lies, and
+ * whatever else the options ask to track.
+ */
+static void reportConvergence()
+{
+    std::cout << "Current difference is " << g_lastDifference 
+              << " at generation " << g_generationCount << ". "
+              << g_lastDrawing->polygons().size() << " polys, "
+              << g_lastDrawing->pointCount() << " points"
+              << std::endl;
+    if (g_bestDrawing)
+        std::cout << "    best so far " << bestDifference() << std::endl;
+    if (g_complexity.enabled())
+        std::cout << "    fitness " << fitness(g_lastDrawing, g_lastDifference) << ", filling "
+                  << ei::ComplexityCost::area(*g_lastDrawing) / (g_width * g_height)
+                  << " canvases" << std::endl;
+    if (!g_programArgs.fullEvaluation)
+    {
+        int tx, ty;
+        g_lastErrors.worstTile(tx, ty);
+        std::cout << "    worst tile (" << tx << ',' << ty << ") holds "
+                  << (100.0 * g_lastErrors.error(tx, ty) / std::max(1u, g_lastErrors.total()))
+                  << "% of the difference" << std::endl;
     }
-    g_endTime = time(NULL);
-    std::cout << g_programArgs.generationLimit << " generations done in "
-              << difftime(g_endTime, g_startTime) << " seconds\n";
-
-    generateLastDrawing();
+    if (g_adaptiveRates)
+    {
+        std::cout << "    rates:";
+        for (int op = 0; op < ei::MutationOpCount; op++)
+            std::cout << ' ' << ei::mutationOpName(ei::MutationOp(op)) << '='
+                      << ei::Settings::activeMutationRate(ei::MutationOp(op));
+        std::cout << std::endl;
+    }
+    if (g_profiler)
+        reportProfile();
+}
 
-    saveDrawingJson(g_lastDrawing);
+/*
+ * Write image as this generation's snapshot, unless one was written
+ * less than renderImageEvery generations ago.
+ */
+static void saveSnapshot(cairo_surface_t *image)
+{
+    static int nextRenderedImage = 0;
+
+    if (g_programArgs.sequence)             // frames have their own outputs
+        return;
+    if (g_generationCount > nextRenderedImage)
+    {
+        renderImageFile(image, g_generationCount);
+        // if every = 100, then next after 171 is (171/100 + 1)*100 = 200
+        nextRenderedImage = ( (g_generationCount / g_programArgs.renderImageEvery + 1) *
+                              g_programArgs.renderImageEvery);
+    } // time to render an image
+}
+
+static void doNextMutation()
+{
+    bool single = !g_worker;                // workers leave output to the main thread
+
+    // Mutation algorithm
+    if (g_generationCount <= g_programArgs.generationLimit)
+    {
+        ei::TraceScope trace("generation");
+        EI_PROBE1(generation_start, g_generationCount);
+
+        // Periodically report current convergence
+        if (single && 0 == g_generationCount % 2000)
+            reportConvergence();
+
+        // 0. Periodically polish every color of the parent in closed form
+        if (g_programArgs.refitEvery > 0 && 0 == g_generationCount % g_programArgs.refitEvery)
+        {
+            refitParent();
+            noteBest();
+        }
+
+        // 0.1 When random mutation has stalled, try a local search pass
+        if (g_programArgs.polishStall > 0 &&
+            g_generationCount - g_lastImprovement >= g_programArgs.polishStall)
+        {
+            int kept = polishParent();
+            noteBest();
+            if (single)
+                std::cout << "Polished at generation " << g_generationCount << ": "
+                          << kept << " moves kept, difference " << g_lastDifference << std::endl;
+            g_lastImprovement = g_generationCount;
+        }
+
+        // 0.2 Periodically drop polygons and vertices the parent does not need
+        if (g_programArgs.pruneEvery > 0 && g_generationCount > 0 &&
+            0 == g_generationCount % g_programArgs.pruneEvery)
+        {
+            int removed = pruneParent();
+            noteBest();
+            if (single && removed)
+                std::cout << "Pruned at generation " << g_generationCount << ": " << removed
+                          << " removed, " << g_lastDrawing->polygons().size() << " polys, "
+                          << g_lastDrawing->pointCount() << " points left, difference "
+                          << g_lastDifference << std::endl;
+        }
+
+        // 1. Clone last drawing and mutate.
+        std::vector<DrawingInfo> children(g_programArgs.numberOfChildren);
+
+        int child;                          // looping index
+        int minChild = 0;                   // child with minimal fitness
+        uint32_t newFitness = UINT32_MAX;
+        uint32_t lastFitness = fitness(g_lastDrawing, g_lastDifference);
+
+        for (child=0; child < g_programArgs.numberOfChildren; child++)
+        {
+            {
+                ei::PhaseTimer timer(g_profiler, ei::PhaseClone);
+                children[child].drawing = g_lastDrawing->clone();
+            }
+            {
+                ei::PhaseTimer timer(g_profiler, ei::PhaseMutate);
+                children[child].drawing->mutate();
+            }
+
+            // 2. Calc difference between child and environment.
+            evaluateChild(children[child], g_lastImage, g_lastErrors, g_lastDifference);
+            uint32_t score = fitness(children[child].drawing, children[child].difference);
+
+            // Locate child with the best fit to environment (smallest fitness)
+            if (child == 0)
+            {
+                newFitness = score;
+                minChild = 0;
+            }
+            else
+            {
+                if (score < newFitness)     // found new min
+                {
+                    minChild = child;
+                    newFitness = score;
+                }
+            }
+        }
+
+        // Everything from here on, but writing snapshots, is selection
+        ei::PhaseTimer selectTimer(g_profiler, ei::PhaseSelect);
+        bool accept = g_acceptance->accept(lastFitness, newFitness,
+                                           g_generationCount, g_programArgs.generationLimit);
+        bool improved = newFitness < bestFitness();
+        if (g_profiler)
+            g_profiler->countGeneration(g_programArgs.numberOfChildren, accept);
+
+        // 2.1 Credit the operators of the accepted child
+        for (child=0; child < g_programArgs.numberOfChildren; child++)
+        {
+            bool accepted = child == minChild && accept;
+            if (accepted)
+                EI_PROBE4(child_accept, g_generationCount, child,
+                          children[child].difference, g_lastDifference);
+            else
+                EI_PROBE4(child_reject, g_generationCount, child,
+                          children[child].difference, g_lastDifference);
+            g_mutationStats.record(*children[child].drawing, accepted,
+                                   accepted && newFitness < lastFitness ?
+                                   lastFitness - newFitness : 0);
+            if (g_adaptiveRates)
+                g_adaptiveRates->record(*children[child].drawing, accepted);
+        }
+        if (g_adaptiveRates && 0 == g_generationCount % g_programArgs.adaptEvery)
+            g_adaptiveRates->update();
+        if (single && 0 == g_generationCount % g_programArgs.opStatsEvery)
+            saveOpStats();
+
+        // 3. If the policy takes the best child (by default, only if its
+        // difference is less than last difference), then save it
+        if (accept)
+        {
+            // 3.1 free last image
+            delete g_lastDrawing;
+
+            // 3.2 save newDrwg&diff as "last"
+            g_lastDrawing = children[minChild].drawing;
+            g_lastDifference = children[minChild].difference;
+            if (improved)
+                g_lastImprovement = g_generationCount;
+            g_lastErrors = children[minChild].errors;
+            children[minChild].drawing = 0;
+            if (g_guidedSampler)
+                g_guidedSampler->update(g_lastErrors);
+            noteBest();
+
+            // 3.3 render image to file named by iteration
+            // but limit it to sparse changes.
+            if (single && improved)
+                saveSnapshot(children[minChild].image);
+
+            // 3.4 keep the child's rendering to draw the next children
+            // over. A child that changed no pixel has none; the parent's is it.
+            if (children[minChild].image)
+            {
+                cairo_surface_destroy(g_lastImage);
+                g_lastImage = children[minChild].image;
+                children[minChild].image = 0;
+            }
+        } // new difference is lower
+
+        // 4 clean up this iteration. If a child improved the
+        // drawing, it's pointer will be 0 already. Delete all
+        // DnaDrawings and gdImagePtrs.
+        for (child=0; child < g_programArgs.numberOfChildren; child++)
+        {
+            delete children[child].drawing;
+            cairo_surface_destroy(children[child].image);
+        }
+        EI_PROBE2(generation_end, g_generationCount, g_lastDifference);
+        if (single)
+        {
+            publishLiveStats(ei::LiveRunning);
+            logProgress(false);
+        }
+    }
+}
+
+/*
+ * --population: a (mu+lambda) population. g_population holds the mu
+ * parents, best first, followed by the lambda (-c) children of the
+ * generation. Its mu+lambda drawings are allocated once: a child slot
+ * is overwritten with a copy of its parent, and selection only moves
+ * the drawings between slots. g_last* follow the best individual.
+ */
+static std::vector<DrawingInfo> g_population;
+static std::vector<DrawingInfo> g_populationScratch;
+static std::vector<int> g_populationParents;   // parent of each child
+static std::vector<int> g_populationRanks;     // slots, best first
+static std::vector<bool> g_populationSurvives;
+
+/*
+ * --eval-threads: the children of a population generation are scored
+ * in parallel. Workers wait on a barrier between batches and score
+ * every nth child; the main thread is worker 0.
+ */
+static pthread_barrier_t g_evalBarrier;
+static std::vector<pthread_t> g_evalThreads;
+static bool g_evalQuit = false;
+
+static void evaluateBatch(int worker)
+{
+    int mu = g_programArgs.population;
+    for (int i = worker; i < g_programArgs.numberOfChildren; i += g_programArgs.evalThreads)
+    {
+        DrawingInfo &parent = g_population[g_populationParents[i]];
+        DrawingInfo &child = g_population[mu + i];
+        evaluateChild(child, parent.image, parent.errors, parent.difference);
+        child.fitness = fitness(child.drawing, child.difference);
+    }
+}
+
+static void *evalWorker(void *arg)
+{
+    int worker = (int)(intptr_t)arg;
+    std::string name = "eval " + std::to_string(worker);
+    ei::TraceBuffer::setThreadName(name.c_str());
+    for (;;)
+    {
+        pthread_barrier_wait(&g_evalBarrier);
+        if (g_evalQuit)
+            break;
+        evaluateBatch(worker);
+        pthread_barrier_wait(&g_evalBarrier);
+    }
+    return 0;
+}
+
+static void stopEvalThreads()
+{
+    if (g_evalThreads.empty())
+        return;
+    g_evalQuit = true;
+    pthread_barrier_wait(&g_evalBarrier);
+    for (size_t i = 0; i < g_evalThreads.size(); i++)
+        pthread_join(g_evalThreads[i], NULL);
+    g_evalThreads.clear();
+    pthread_barrier_destroy(&g_evalBarrier);
+    g_evalQuit = false;                     // a restart may start them again
+}
+
+/*
+ * Copy the best individual to g_last* if it beats them.
+ */
+static void adoptBestIndividual()
+{
+    DrawingInfo &best = g_population[0];
+    if (g_lastDrawing && best.fitness >= fitness(g_lastDrawing, g_lastDifference))
+        return;
+
+    if (g_lastDrawing)
+        g_lastDrawing->copyFrom(*best.drawing);
+    else
+        g_lastDrawing = best.drawing->clone();
+    cairo_surface_destroy(g_lastImage);
+    g_lastImage = cairo_surface_reference(best.image);
+    g_lastErrors = best.errors;
+    g_lastDifference = best.difference;
+    g_lastImprovement = g_generationCount;
+    if (g_guidedSampler)
+        g_guidedSampler->update(g_lastErrors);
+}
+
+static ei::DnaDrawing *perturbedCopy(ei::DnaDrawing *d);
+
+/*
+ * Seed the population with the parent and mu-1 new drawings (or, when
+ * restarting, perturbed copies of the parent), and start the
+ * evaluation workers.
+ */
+static void startPopulation(bool perturb)
+{
+    int mu = g_programArgs.population;
+    int size = mu + g_programArgs.numberOfChildren;
+    g_population.resize(size);
+    g_populationScratch.resize(size);
+    g_populationParents.resize(g_programArgs.numberOfChildren);
+    g_populationRanks.resize(size);
+    g_populationSurvives.resize(size);
+
+    for (int i = 0; i < mu; i++)
+    {
+        DrawingInfo &info = g_population[i];
+        // --init grid and kmeans always seed the same drawing, so the
+        // others start as variations of it rather than at random
+        if (i == 0)
+            info.drawing = g_lastDrawing->clone();
+        else if (perturb || g_programArgs.initMode != InitRandom)
+            info.drawing = perturbedCopy(g_lastDrawing);
+        else
+            info.drawing = newDrawing(ei::DnaRect(0, 0, g_width, g_height));
+        info.image = renderDrawing(info.drawing);
+        info.errors.reset(g_width, g_height, g_programArgs.tileSize);
+        diffTiles(info.image, info.errors, 0, 0, info.errors.tilesX(), info.errors.tilesY());
+        info.difference = g_programArgs.fullEvaluation ? diffImages(info.image) : info.errors.total();
+        info.fitness = fitness(info.drawing, info.difference);
+    }
+    for (int i = mu; i < size; i++)
+        g_population[i].drawing = g_lastDrawing->clone();
+    std::stable_sort(g_population.begin(), g_population.begin() + mu,
+                     [](DrawingInfo const &a, DrawingInfo const &b)
+                     { return a.fitness < b.fitness; });
+    adoptBestIndividual();
+
+    if (g_programArgs.evalThreads > 1)
+    {
+        pthread_barrier_init(&g_evalBarrier, NULL, g_programArgs.evalThreads);
+        for (int i = 1; i < g_programArgs.evalThreads; i++)
+        {
+            pthread_t thread;
+            pthread_create(&thread, NULL, evalWorker, (void*)(intptr_t)i);
+            g_evalThreads.push_back(thread);
+        }
+    }
+}
+
+static void freePopulation()
+{
+    stopEvalThreads();
+    for (size_t i = 0; i < g_population.size(); i++)
+    {
+        delete g_population[i].drawing;
+        cairo_surface_destroy(g_population[i].image);
+    }
+    g_population.clear();
+    g_populationScratch.clear();
+    g_populationRanks.clear();
+    g_populationSurvives.clear();
+}
+
+/*
+ * The best of tournamentSize random parents. Parents are sorted, so
+ * that is the one with the lowest index.
+ */
+static int tournamentSelect()
+{
+    int winner = g_programArgs.population - 1;
+    for (int i = 0; i < g_programArgs.tournamentSize; i++)
+        winner = std::min(winner, ei::Tools::getRandomNumber(0, g_programArgs.population - 1));
+    return winner;
+}
+
+/*
+ * One (mu+lambda) generation: lambda children of tournament-selected
+ * parents (optionally crossed over with a second one), scored in
+ * parallel, then the best mu of parents and children survive.
+ */
+static void doNextPopulation()
+{
+    bool single = !g_worker;
+    int mu = g_programArgs.population;
+    int lambda = g_programArgs.numberOfChildren;
+
+    if (g_generationCount > g_programArgs.generationLimit)
+        return;
+    ei::TraceScope trace("generation");
+    EI_PROBE1(generation_start, g_generationCount);
+
+    if (single && 0 == g_generationCount % 2000)
+        reportConvergence();
+
+    // 1. Breed the children (on this thread, so the random stream stays reproducible)
+    for (int i = 0; i < lambda; i++)
+    {
+        DrawingInfo &child = g_population[mu + i];
+        int parent = tournamentSelect();
+        g_populationParents[i] = parent;
+        {
+            ei::PhaseTimer timer(g_profiler, ei::PhaseClone);
+            child.drawing->copyFrom(*g_population[parent].drawing);
+        }
+        ei::PhaseTimer timer(g_profiler, ei::PhaseMutate);
+        if (mu > 1 && ei::Tools::getRandomNumber(0, 99) < g_programArgs.crossoverPercent)
+            child.drawing->crossover(*g_population[tournamentSelect()].drawing);
+        child.drawing->mutate();
+    }
+
+    // 2. Score them
+    if (g_evalThreads.empty())
+        evaluateBatch(0);
+    else
+    {
+        pthread_barrier_wait(&g_evalBarrier);
+        evaluateBatch(0);
+        pthread_barrier_wait(&g_evalBarrier);
+    }
+
+    ei::PhaseTimer selectTimer(g_profiler, ei::PhaseSelect);
+    for (int i = 0; i < lambda; i++)
+    {
+        DrawingInfo &child = g_population[mu + i];
+        if (!child.image)                   // looks just like its parent
+            child.image = cairo_surface_reference(g_population[g_populationParents[i]].image);
+    }
+
+    // 3. Keep the best mu; on a tie the older individual stays
+    std::vector<int> &ranks = g_populationRanks;
+    std::vector<bool> &survives = g_populationSurvives;
+    for (int i = 0; i < mu + lambda; i++)
+    {
+        ranks[i] = i;
+        survives[i] = false;
+    }
+    std::stable_sort(ranks.begin(), ranks.end(), [](int a, int b)
+                     { return g_population[a].fitness < g_population[b].fitness; });
+    for (int i = 0; i < mu; i++)
+        survives[ranks[i]] = true;
+
+    int accepted = 0;
+    for (int i = 0; i < lambda; i++)
+    {
+        DrawingInfo &child = g_population[mu + i];
+        uint32_t parentFitness = g_population[g_populationParents[i]].fitness;
+        bool kept = survives[mu + i];
+        if (kept)
+        {
+            accepted++;
+            EI_PROBE4(child_accept, g_generationCount, i, child.difference,
+                      g_population[g_populationParents[i]].difference);
+        }
+        else
+            EI_PROBE4(child_reject, g_generationCount, i, child.difference,
+                      g_population[g_populationParents[i]].difference);
+        g_mutationStats.record(*child.drawing, kept,
+                               kept && child.fitness < parentFitness ?
+                               parentFitness - child.fitness : 0);
+        if (g_adaptiveRates)
+            g_adaptiveRates->record(*child.drawing, kept);
+    }
+    if (g_profiler)
+        g_profiler->countGeneration(lambda, accepted > 0);
+    if (g_adaptiveRates && 0 == g_generationCount % g_programArgs.adaptEvery)
+        g_adaptiveRates->update();
+    if (single && 0 == g_generationCount % g_programArgs.opStatsEvery)
+        saveOpStats();
+
+    for (int i = 0; i < mu + lambda; i++)
+        std::swap(g_populationScratch[i], g_population[ranks[i]]);
+    g_population.swap(g_populationScratch);
+    for (int i = mu; i < mu + lambda; i++)
+    {
+        // the losers' drawings become the next generation's child slots
+        cairo_surface_destroy(g_population[i].image);
+        g_population[i].image = 0;
+    }
+
+    // 4. Follow the best
+    uint32_t lastDifference = g_lastDifference;
+    adoptBestIndividual();
+    if (single && g_lastDifference < lastDifference)
+        saveSnapshot(g_lastImage);
+
+    EI_PROBE2(generation_end, g_generationCount, g_lastDifference);
+    if (single)
+    {
+        publishLiveStats(ei::LiveRunning);
+        logProgress(false);
+    }
+}
+
+/*
+ * Write out drawing's polygons in JSON, if a filename was given.
+ */
+void saveDrawingJson(ei::DnaDrawing *drawing, std::string const &filename)
+{
+    if (0 == filename.length())
+        return;
+    ei::PhaseTimer timer(g_profiler, ei::PhaseSnapshot);
+    ei::TraceScope trace("snapshot");
+
+    if (!ei::DrawingJson::save(drawing, filename))
+    {
+        std::cout << "Cannot open JSON output file "
+                  << filename << std::endl;
+        return;
+    }
+    std::cout << "Wrote drawing to JSON file "
+              << filename << std::endl;
+}
+
+/*
+ * Write the per-operator statistics so far, if a filename was given.
+ * A .json file is rewritten with the cumulative totals each time; any
+ * other name gets one CSV row per operator appended per call. Under
+ * --adapt-rates each operator also says whether it is scored yet, i.e.
+ * whether its rate is being re-weighted.
+ */
+static void saveOpStats()
+{
+    static bool started = false;
+    static int lastGeneration = -1;
+    std::string const &name = g_programArgs.opStatsFilename;
+    int generation = std::min(g_generationCount, g_programArgs.generationLimit);
+    if (0 == name.length() || generation == lastGeneration)
+        return;
+    ei::PhaseTimer timer(g_profiler, ei::PhaseSnapshot);
+    ei::TraceScope trace("snapshot");
+
+    bool json = name.length() > 5 && 0 == name.compare(name.length() - 5, 5, ".json");
+    std::ofstream outfile(name, (json || !started) ? std::ios::trunc : std::ios::app);
+    if (!outfile.is_open())
+    {
+        std::cout << "Cannot open operator statistics file " << name << std::endl;
+        return;
+    }
+
+    if (json)
+    {
+        Json::Value stats;
+        stats["generation"] = generation;
+        stats["difference"] = g_lastDifference;
+        stats["children"] = Json::UInt64(g_mutationStats.children());
+        stats["accepted"] = Json::UInt64(g_mutationStats.accepted());
+
+        Json::Value ops;
+        for (int i = 0; i < ei::MutationOpCount; i++)
+        {
+            ei::MutationOpStats const &op = g_mutationStats.op(ei::MutationOp(i));
+            Json::Value opval;
+            opval["fired"] = Json::UInt64(op.fired);
+            opval["children"] = Json::UInt64(op.children);
+            opval["accepted"] = Json::UInt64(op.accepted);
+            opval["improvement"] = Json::UInt64(op.improvement);
+            opval["rate"] = ei::Settings::activeMutationRate(ei::MutationOp(i));
+            if (g_adaptiveRates)
+                opval["scored"] = g_adaptiveRates->scored(ei::MutationOp(i));
+            ops[ei::mutationOpName(ei::MutationOp(i))] = opval;
+        }
+        stats["operators"] = ops;
+
+        Json::StreamWriterBuilder builder;
+        builder["indentation"] = "    ";
+        std::unique_ptr<Json::StreamWriter> writer( builder.newStreamWriter() );
+        writer->write(stats, &outfile);
+        outfile << std::endl;
+    }
+    else
+    {
+        if (!started)
+            outfile << "generation,difference,operator,fired,children,accepted,improvement,rate,scored\n";
+        for (int i = 0; i < ei::MutationOpCount; i++)
+        {
+            ei::MutationOpStats const &op = g_mutationStats.op(ei::MutationOp(i));
+            outfile << generation << ',' << g_lastDifference << ','
+                    << ei::mutationOpName(ei::MutationOp(i)) << ','
+                    << op.fired << ',' << op.children << ','
+                    << op.accepted << ',' << op.improvement << ','
+                    << ei::Settings::activeMutationRate(ei::MutationOp(i)) << ',';
+            if (g_adaptiveRates)
+                outfile << g_adaptiveRates->scored(ei::MutationOp(i));
+            outfile << '\n';
+        }
+    }
+    started = true;
+    lastGeneration = generation;
+}
+
+/*
+ * A copy of d that --perturb rounds of mutation moved away from it
+ */
+static ei::DnaDrawing *perturbedCopy(ei::DnaDrawing *d)
+{
+    ei::DnaDrawing *copy = d->clone();
+    for (int i = 0; i < g_programArgs.perturbRounds; i++)
+        copy->mutate();
+    return copy;
+}
+
+static thread_local ei::PlateauDetector *g_plateau = 0;
+static thread_local int g_restarts = 0;     // plateaus restarted from so far
+
+/*
+ * Forget this lineage's plateau history and restarts, e.g. for a new frame
+ */
+static void resetStop()
+{
+    delete g_plateau;
+    g_plateau = 0;
+    g_restarts = 0;
+}
+
+static bool deadlinePassed()
+{
+    return g_programArgs.deadline > 0 &&
+        std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                      g_processStart).count() >= g_programArgs.deadline;
+}
+
+/*
+ * Check the stopping criteria after a generation of this lineage.
+ * Returns why it should stop, or 0 to go on. A plateau with restarts
+ * left instead restarts the lineage from a perturbed copy of its best
+ * drawing; the best is kept, so the run can only end up better.
+ */
+static const char *checkStop()
+{
+    if (deadlinePassed())
+        return "deadline reached";
+    if (bestDifference() <= g_programArgs.targetDifference)
+        return "target difference reached";
+    if (g_programArgs.plateauWindow == 0)
+        return 0;
+
+    if (!g_plateau)
+        g_plateau = new ei::PlateauDetector(g_programArgs.plateauWindow,
+                                            g_programArgs.plateauGain / 100);
+    if (!g_plateau->update(bestDifference()))
+        return 0;
+    if (g_restarts >= g_programArgs.restarts)
+    {
+        delete g_plateau;
+        g_plateau = 0;
+        return "plateau";
+    }
+
+    g_restarts++;
+    g_plateau->reset();
+    noteBest();
+    ei::DnaDrawing *best = g_bestDrawing ? g_bestDrawing : g_lastDrawing;
+    if (g_programArgs.population > 0)
+    {
+        freePopulation();
+        startPopulation(true);
+    }
+    else
+        startLineage(perturbedCopy(best));
+    g_lastImprovement = g_generationCount;
+    if (!g_worker)
+        std::cout << "Plateau at generation " << g_generationCount << ", restart "
+                  << g_restarts << " from difference " << g_lastDifference << std::endl;
+    return 0;
+}
+
+/*
+ * Islands show each other (and the main thread) their progress through
+ * the mailbox. A drawing is posted every g_postEvery generations if it
+ * improved, and always at migration time and at the end.
+ */
+static ei::IslandMailbox g_mailbox;
+static int g_postEvery;
+
+/*
+ * Offer this island's parent to the others, and adopt the drawing last
+ * posted by its source island (the previous one on the ring, or any
+ * other at random) if that is better than what the island has.
+ */
+static void migrate(int island)
+{
+    static thread_local std::vector<uint32_t> taken;
+    int count = g_programArgs.islands;
+    taken.resize(count);
+
+    int source = (island + count - 1) % count;
+    if (g_programArgs.randomTopology && count > 1)
+        source = (island + 1 + ei::Tools::getRandomNumber(0, count - 2)) % count;
+    ei::DnaDrawing *migrant = source == island ? 0 : g_mailbox.take(source, taken[source]);
+    if (!migrant)
+        return;
+
+    cairo_surface_t *image = renderDrawing(migrant);
+    uint32_t difference = diffImages(image);
+    cairo_surface_destroy(image);
+    if (fitness(migrant, difference) < fitness(g_lastDrawing, g_lastDifference))
+    {
+        startLineage(migrant);
+        g_lastImprovement = g_generationCount;
+    }
+    else
+        delete migrant;
+}
+
+/*
+ * Body of one island, run on its own thread or in a forked worker: an
+ * independent 1+lambda lineage with its own random stream, guided
+ * sampler and statistics.
+ */
+static void *runIsland(void *arg)
+{
+    int island = (int)(intptr_t)arg;
+    ei::IslandSlot &slot = g_mailbox.slot(island);
+
+    std::string name = "island " + std::to_string(island);
+    ei::TraceBuffer::setThreadName(name.c_str());
+    g_worker = true;
+    ei::Tools::seedThread(uint64_t(g_programArgs.seed) * 1000003 + island);
+    if (g_programArgs.guidedPercent > 0)
+    {
+        g_guidedSampler = new ei::GuidedSampler(g_programArgs.guidedPercent);
+        ei::Tools::setPositionSampler(g_guidedSampler);
+    }
+
+    startLineage(newDrawing(ei::DnaRect(0, 0, g_width, g_height)));
+
+    int lastPost = -1;
+    for (g_generationCount = 1; g_generationCount <= g_programArgs.generationLimit; ++g_generationCount)
+    {
+        doNextMutation();
+
+        bool migrating = 0 == g_generationCount % g_programArgs.migrateEvery;
+        if (migrating || (0 == g_generationCount % g_postEvery && g_lastImprovement > lastPost))
+        {
+            g_mailbox.post(island, *g_lastDrawing);
+            lastPost = g_generationCount;
+        }
+        if (migrating)
+            migrate(island);
+
+        slot.difference = bestDifference();
+        slot.fitness = bestFitness();
+        slot.polygons = g_lastDrawing->polygons().size();
+        slot.points = g_lastDrawing->pointCount();
+        slot.lastImprovement = g_lastImprovement;
+        slot.generation = g_generationCount;
+
+        const char *stop = checkStop();
+        if (stop && g_generationCount < g_programArgs.generationLimit)
+        {
+            std::cout << "Island " << island << " stopping after generation "
+                      << g_generationCount << ": " << stop << std::endl;
+            break;
+        }
+    }
+
+    restoreBest();
+    slot.difference = g_lastDifference;
+    slot.fitness = fitness(g_lastDrawing, g_lastDifference);
+    g_mailbox.post(island, *g_lastDrawing);
+    slot.stats = g_mutationStats;
+    slot.done.store(1, std::memory_order_release);
+
+    delete g_lastDrawing;
+    g_lastDrawing = 0;
+    cairo_surface_destroy(g_lastImage);
+    g_lastImage = 0;
+    ei::Tools::setPositionSampler(0);
+    delete g_guidedSampler;
+    g_guidedSampler = 0;
+    g_worker = false;
+    return 0;
+}
+
+/*
+ * Share the prepared environment with forked workers: write it to a
+ * file in /dev/shm, map that read-only in its place, and unlink it.
+ * The workers inherit the mapping, so every process reads one copy.
+ */
+static void shareTarget()
+{
+    char filename[64];
+    snprintf(filename, sizeof(filename), "/dev/shm/evoimage-%d.target", (int)getpid());
+    bool saved = g_target.save(filename);
+    bool ok = saved && g_target.map(filename);
+    unlink(filename);
+    if (saved && !ok && !loadEnvironmentPng())
+    {
+        std::cout << "Cannot share or reload the environment image\n";
+        exit(1);
+    }
+    g_target.setYccWeights(g_programArgs.lumaWeight, g_programArgs.chromaWeight);
+    if (!ok)
+        std::cout << "Cannot share the environment in /dev/shm; workers keep copies\n";
+}
+
+/*
+ * Evolve --islands lineages side by side, on threads or, with
+ * --processes, in forked workers. The main thread (the coordinator)
+ * reports the best of them and writes its snapshots, then adopts the
+ * best final drawing as its own.
+ */
+static void runIslands()
+{
+    int count = g_programArgs.islands;
+    std::cout << "Evolving " << count << " islands in "
+              << (g_programArgs.islandProcesses ? "worker processes" : "threads")
+              << ", migrating every " << g_programArgs.migrateEvery << " generations ("
+              << (g_programArgs.randomTopology ? "random" : "ring") << ")\n";
+    renderImageFile(g_environmentImage, 0);     // save environment as 0
+
+    g_postEvery = std::max(1, std::min(g_programArgs.migrateEvery, g_programArgs.renderImageEvery));
+    if (!g_mailbox.create(count, g_programArgs.polygonsMax, g_programArgs.pointsMax))
+    {
+        std::cout << "Cannot map the island mailbox\n";
+        exit(1);
+    }
+
+    std::vector<pthread_t> threads(count);
+    std::vector<pid_t> workers(count, -1);
+    if (g_programArgs.islandProcesses)
+    {
+        shareTarget();
+        std::cout.flush();
+        if (g_progressFile)
+            fflush(g_progressFile);
+        for (int i = 0; i < count; i++)
+        {
+            workers[i] = fork();
+            if (workers[i] == 0)
+            {
+                // A worker traces itself to <trace>.island<i>, without the
+                // coordinator's events it inherited
+                ei::TraceBuffer::discard();
+                runIsland((void*)(intptr_t)i);
+                std::cout.flush();
+                if (ei::TraceBuffer::enabled())
+                {
+                    std::string name = g_programArgs.traceFilename + ".island" + std::to_string(i);
+                    if (!ei::TraceBuffer::write(name.c_str()))
+                        std::cout << "Cannot write trace file " << name << std::endl;
+                }
+                _exit(0);                   // leave the coordinator's files alone
+            }
+            if (workers[i] < 0)
+                std::cout << "Cannot fork island " << i << std::endl;
+        }
+    }
+    else
+    {
+        for (int i = 0; i < count; i++)
+            pthread_create(&threads[i], NULL, runIsland, (void*)(intptr_t)i);
+    }
+
+    // Monitor: the run is as far as its slowest island, as good as its best
+    int nextReport = 2000;
+    int nextRenderedImage = 0;
+    std::vector<uint32_t> snapshotSerials(count);
+    bool running = true;
+    while (running)
+    {
+        usleep(10000);
+        running = false;
+        int best = 0;
+        int generation = INT_MAX;
+        for (int i = 0; i < count; i++)
+        {
+            ei::IslandSlot &slot = g_mailbox.slot(i);
+            if (workers[i] > 0 && !slot.done && waitpid(workers[i], NULL, WNOHANG) == workers[i])
+            {
+                std::cout << "Island " << i << " exited early\n";
+                workers[i] = -1;
+            }
+            if (slot.done || (g_programArgs.islandProcesses && workers[i] < 0))
+                continue;
+            running = true;
+            generation = std::min(generation, slot.generation.load());
+            if (slot.fitness < g_mailbox.slot(best).fitness)
+                best = i;
+        }
+        if (!running)
+            break;
+
+        ei::IslandSlot &bestSlot = g_mailbox.slot(best);
+        g_lastDifference = bestSlot.difference;
+        g_generationCount = generation;
+        g_lastImprovement = bestSlot.lastImprovement;
+        if (g_liveStats.isOpen())
+        {
+            g_liveStats.data().polygons = bestSlot.polygons;
+            g_liveStats.data().points = bestSlot.points;
+        }
+        publishLiveStats(ei::LiveRunning);
+        logProgress(false);
+
+        if (generation > nextRenderedImage && generation <= g_programArgs.generationLimit)
+        {
+            ei::DnaDrawing *snapshot = g_mailbox.take(best, snapshotSerials[best]);
+            if (snapshot)
+            {
+                cairo_surface_t *image = renderDrawing(snapshot);
+                renderImageFile(image, generation);
+                cairo_surface_destroy(image);
+                delete snapshot;
+                nextRenderedImage = ( (generation / g_programArgs.renderImageEvery + 1) *
+                                      g_programArgs.renderImageEvery);
+            }
+        }
+
+        if (generation >= nextReport && generation <= g_programArgs.generationLimit)
+        {
+            std::cout << "Generation " << generation << ": best difference "
+                      << g_lastDifference << " (island " << best << "), islands";
+            for (int i = 0; i < count; i++)
+                std::cout << ' ' << g_mailbox.slot(i).difference;
+            std::cout << std::endl;
+            nextReport = (generation / 2000 + 1) * 2000;
+        }
+    }
+
+    for (int i = 0; i < count; i++)
+    {
+        if (g_programArgs.islandProcesses)
+        {
+            if (workers[i] > 0)
+                waitpid(workers[i], NULL, 0);
+        }
+        else
+            pthread_join(threads[i], NULL);
+    }
+
+    // Adopt the best drawing any island finished with
+    int best = -1;
+    int generations = 0;
+    for (int i = 0; i < count; i++)
+    {
+        ei::IslandSlot &slot = g_mailbox.slot(i);
+        if (!slot.done)
+            continue;
+        generations = std::max(generations, slot.generation.load());
+        g_mutationStats.add(slot.stats);
+        if (best < 0 || slot.fitness < g_mailbox.slot(best).fitness)
+            best = i;
+    }
+    uint32_t serial = 0;
+    ei::DnaDrawing *result = best < 0 ? 0 : g_mailbox.take(best, serial);
+    if (!result)
+    {
+        std::cout << "No island finished\n";
+        exit(1);
+    }
+    startLineage(result);
+    g_mailbox.close();
+    g_generationCount = generations;
+    std::cout << "Best island: " << best << ", difference " << g_lastDifference;
+    if (g_complexity.enabled())
+        std::cout << ", fitness " << fitness(g_lastDrawing, g_lastDifference);
+    std::cout << std::endl;
+}
+
+/*
+ * Iterate the generations of one run, starting from seed (which is
+ * taken over) or, without one, from a new drawing. Ends with the best
+ * drawing as the parent, polished if asked to. Returns why the run
+ * stopped early, or 0 if it ran to the generation limit.
+ */
+static const char *evolve(ei::DnaDrawing *seed)
+{
+    const char *stopped = 0;
+
+    g_generationCount = 0;
+    g_lastImprovement = 0;
+    resetStop();
+    g_startTime = time(NULL);
+    if (g_programArgs.islands > 0)
+        runIslands();
+    while (0 == g_programArgs.islands && g_generationCount <= g_programArgs.generationLimit) {
+        if (g_generationCount == 0)
+        {
+            g_startTime = time(NULL);
+            if (seed)
+            {
+                startLineage(seed);
+                std::cout << "Seeded difference = " << g_lastDifference << std::endl;
+            }
+            else
+                generateFirstDrawing();
+            if (g_programArgs.population > 0)
+                startPopulation(false);
+            logProgress(true);
+        }
+        else if (g_programArgs.population > 0)
+        {
+            doNextPopulation();
+        }
+        else // all other increments
+        {
+            doNextMutation();
+        }
+
+        const char *stop = checkStop();
+        if (stop && g_generationCount < g_programArgs.generationLimit)
+        {
+            std::cout << "Stopping after generation " << g_generationCount << ": " << stop << std::endl;
+            stopped = stop;
+            break;
+        }
+        ++g_generationCount;
+    }
+    g_endTime = time(NULL);
+    freePopulation();
+    restoreBest();
+    std::cout << std::min(g_generationCount, g_programArgs.generationLimit) << " generations done in "
+              << difftime(g_endTime, g_startTime) << " seconds\n";
+
+    for (int pass = 0; pass < g_programArgs.polishEnd; pass++)
+    {
+        int kept = polishParent();
+        logProgress(false);
+        std::cout << "Polish pass " << pass + 1 << ": " << kept
+                  << " moves kept, difference " << g_lastDifference << std::endl;
+        if (kept == 0)
+            break;
+    }
+    if (g_programArgs.polishEnd > 0)
+        std::cout << "Polishing done in " << difftime(time(NULL), g_endTime) << " seconds\n";
+    if (g_programArgs.pruneEvery > 0)
+    {
+        int removed = pruneParent();
+        logProgress(false);
+        std::cout << "Pruned " << removed << " at the end: " << g_lastDrawing->polygons().size()
+                  << " polys, " << g_lastDrawing->pointCount() << " points, difference "
+                  << g_lastDifference << std::endl;
+    }
+    return stopped;
+}
+
+/*
+ * --sequence: frame f+1 evolves from the drawing frame f ended with, so
+ * later frames only pay for what changed between them. With --pipeline
+ * the next frame is loaded, and the last one written, on threads of
+ * their own while the current one evolves.
+ */
+struct FrameOutput
+{
+    int frame;                              // numbered from 1
+    ei::DnaDrawing *drawing;
+    cairo_surface_t *image;
+};
+
+struct FramePrefetch
+{
+    const char *filename;
+    ei::TargetImage target;
+    cairo_surface_t *surface;
+    int loaded;
+};
+
+static pthread_mutex_t g_writerLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t g_writerWake = PTHREAD_COND_INITIALIZER;
+static std::deque<FrameOutput> g_writerQueue;
+static bool g_writerQuit = false;
+
+/*
+ * Write a finished frame as PNG and JSON, and free it
+ */
+static void writeFrame(FrameOutput const &out)
+{
+    char filename[100];
+    sprintf(filename, "mutations/frame-%05d.png", out.frame);
+    cairo_surface_write_to_png(out.image, filename);
+    sprintf(filename, "mutations/frame-%05d.json", out.frame);
+    saveDrawingJson(out.drawing, filename);
+
+    delete out.drawing;
+    cairo_surface_destroy(out.image);
+}
+
+static void *frameWriter(void *)
+{
+    pthread_mutex_lock(&g_writerLock);
+    for (;;)
+    {
+        while (g_writerQueue.empty() && !g_writerQuit)
+            pthread_cond_wait(&g_writerWake, &g_writerLock);
+        if (g_writerQueue.empty())
+            break;
+        FrameOutput out = g_writerQueue.front();
+        g_writerQueue.pop_front();
+        pthread_mutex_unlock(&g_writerLock);
+        writeFrame(out);
+        pthread_mutex_lock(&g_writerLock);
+    }
+    pthread_mutex_unlock(&g_writerLock);
+    return 0;
+}
+
+static void *prefetchFrame(void *arg)
+{
+    FramePrefetch *next = (FramePrefetch*)arg;
+    next->loaded = loadTarget(next->filename, next->target, next->surface);
+    return 0;
+}
+
+static void runSequence()
+{
+    std::vector<std::string> const &frames = g_programArgs.frames;
+    int frameLimit = g_programArgs.frameGenerations > 0 ?
+        g_programArgs.frameGenerations : g_programArgs.generationLimit;
+    FramePrefetch next;
+    pthread_t prefetcher, writer;
+    bool prefetching = false;
+    time_t sequenceStart = time(NULL);
+    size_t done = 0;
+
+    if (!loadEnvironmentPng())
+        return;
+    if (g_programArgs.pipeline)
+        pthread_create(&writer, NULL, frameWriter, NULL);
+
+    for (size_t f = 0; f < frames.size(); f++)
+    {
+        if (f > 0)
+        {
+            cairo_surface_t *surface = 0;
+            int loaded;
+            if (prefetching)
+            {
+                pthread_join(prefetcher, NULL);
+                prefetching = false;
+                loaded = next.loaded;
+                g_target.swap(next.target);
+                surface = next.surface;
+            }
+            else
+                loaded = loadTarget(frames[f].c_str(), g_target, surface);
+            if (!loaded)
+            {
+                cairo_surface_destroy(surface);
+                break;
+            }
+            cairo_surface_destroy(g_environmentImage);
+            g_environmentImage = surface;
+            g_programArgs.generationLimit = frameLimit;
+        }
+        if (g_programArgs.pipeline && f + 1 < frames.size())
+        {
+            next.filename = frames[f + 1].c_str();
+            next.surface = 0;
+            pthread_create(&prefetcher, NULL, prefetchFrame, &next);
+            prefetching = true;
+        }
+
+        std::cout << "Frame " << f + 1 << " of " << frames.size() << ": " << frames[f] << std::endl;
+        const char *stop = evolve(f > 0 ? g_lastDrawing->clone() : 0);
+
+        FrameOutput out = {int(f + 1), g_lastDrawing->clone(), renderDrawing(g_lastDrawing)};
+        if (g_programArgs.pipeline)
+        {
+            pthread_mutex_lock(&g_writerLock);
+            g_writerQueue.push_back(out);
+            pthread_cond_signal(&g_writerWake);
+            pthread_mutex_unlock(&g_writerLock);
+        }
+        else
+            writeFrame(out);
+        done++;
+        if (stop && deadlinePassed())
+            break;
+    }
+
+    if (prefetching)
+    {
+        pthread_join(prefetcher, NULL);
+        cairo_surface_destroy(next.surface);
+    }
+    if (g_programArgs.pipeline)
+    {
+        pthread_mutex_lock(&g_writerLock);
+        g_writerQuit = true;
+        pthread_cond_signal(&g_writerWake);
+        pthread_mutex_unlock(&g_writerLock);
+        pthread_join(writer, NULL);
+    }
+    std::cout << done << " of " << frames.size() << " frames done in "
+              << difftime(time(NULL), sequenceStart) << " seconds\n";
+}
+
+/*
+ * --split: every region of the canvas evolves a drawing of its own on a
+ * thread, its points confined to the region and the overlap around it,
+ * so a child only re-renders and re-diffs tiles there. The regions'
+ * polygons are then merged into one drawing, which evolves as a whole
+ * for --split-refine generations to repair the seams.
+ */
+struct SplitRegion
+{
+    int index;
+    int x0, y0, x1, y1;                     // bounds of its points, inclusive
+    ei::DnaDrawing *drawing;                // the region's best, once done
+    int generations;
+    ei::MutationStats stats;
+};
+
+static void *runRegion(void *arg)
+{
+    SplitRegion &region = *(SplitRegion*)arg;
+
+    std::string name = "region " + std::to_string(region.index);
+    ei::TraceBuffer::setThreadName(name.c_str());
+    g_worker = true;
+    ei::Tools::seedThread(uint64_t(g_programArgs.seed) * 1000003 + region.index);
+    ei::Tools::setBounds(region.x0, region.y0, region.x1, region.y1);
+
+    startLineage(newDrawing(ei::DnaRect(region.x0, region.y0, region.x1, region.y1)));
+    for (g_generationCount = 1; g_generationCount <= g_programArgs.generationLimit; ++g_generationCount)
+    {
+        doNextMutation();
+        if (checkStop() && g_generationCount < g_programArgs.generationLimit)
+            break;
+    }
+    restoreBest();
+    resetStop();
+
+    region.drawing = g_lastDrawing;
+    region.generations = std::min(g_generationCount, g_programArgs.generationLimit);
+    region.stats = g_mutationStats;
+    g_lastDrawing = 0;
+    cairo_surface_destroy(g_lastImage);
+    g_lastImage = 0;
+    return 0;
+}
+
+static void runSplit(ei::Settings &settings)
+{
+    int columns = g_programArgs.splitColumns;
+    int rows = g_programArgs.splitRows;
+    int count = columns * rows;
+    int overlap = g_programArgs.splitOverlap;
+    std::vector<SplitRegion> regions(count);
+    std::vector<pthread_t> threads(count);
+
+    // Each region gets an even share of the drawing's polygons and points
+    // (checkArgs made sure a share is enough for a region's minimum), so
+    // the merged drawing is within the drawing's own limits
+    ei::Settings regionSettings = settings;
+    regionSettings.setPolygonsMax(settings.polygonsMax() / count);
+    regionSettings.setPointsMax(settings.pointsMax() / count);
+    regionSettings.activate();
+
+    g_startTime = time(NULL);
+    renderImageFile(g_environmentImage, 0);     // save environment as 0
+    for (int i = 0; i < count; i++)
+    {
+        SplitRegion &region = regions[i];
+        int column = i % columns, row = i / columns;
+        region.index = i;
+        region.x0 = std::max(0, column * g_width / columns - overlap);
+        region.y0 = std::max(0, row * g_height / rows - overlap);
+        region.x1 = std::min(g_width, (column + 1) * g_width / columns + overlap);
+        region.y1 = std::min(g_height, (row + 1) * g_height / rows + overlap);
+        region.drawing = 0;
+        pthread_create(&threads[i], NULL, runRegion, &region);
+    }
+
+    ei::DnaDrawing *merged = 0;
+    for (int i = 0; i < count; i++)
+    {
+        SplitRegion &region = regions[i];
+        pthread_join(threads[i], NULL);
+        std::cout << "Region " << i << " (" << region.x0 << ',' << region.y0 << ")-("
+                  << region.x1 << ',' << region.y1 << "): " << region.generations
+                  << " generations, " << region.drawing->polygons().size() << " polys, "
+                  << region.drawing->pointCount() << " points" << std::endl;
+        g_mutationStats.add(region.stats);
+
+        // Later regions paint over earlier ones where they overlap
+        if (!merged)
+            merged = region.drawing;
+        else
+        {
+            ei::DnaPolygonList &polygons = region.drawing->polygons();
+            merged->polygons().insert(merged->polygons().end(), polygons.begin(), polygons.end());
+            delete region.drawing;
+        }
+    }
+    std::cout << count << " regions done in " << difftime(time(NULL), g_startTime) << " seconds\n";
+
+    settings.activate();
+    int generationLimit = g_programArgs.generationLimit;
+    g_programArgs.generationLimit = g_programArgs.splitRefine;
+    evolve(merged);
+    g_programArgs.generationLimit = generationLimit;
+}
+
+int main(int argc, char *argv[])
+{
+    checkArgs(argc, argv);
+    std::cout << "Settings:\n"
+              << "    rendering image every ~"
+              << g_programArgs.renderImageEvery << std::endl
+              << "    children/generation: "
+              << g_programArgs.numberOfChildren << std::endl
+              << "    number of generations: "
+              << g_programArgs.generationLimit << std::endl
+              << "    environment image: "
+              << g_programArgs.environmentFilename << std::endl
+              << "    max polygons: "
+              << g_programArgs.polygonsMax << std::endl
+              << "    max points/poly: "
+              << g_programArgs.pointsMax << std::endl
+              << "    evaluation: "
+              << (g_programArgs.diffMode == ei::DiffYcc ? "ycc" : "rgb") << std::endl;
+    if (g_programArgs.sequence)
+        std::cout << "    frames: " << g_programArgs.frames.size() << ", later ones "
+                  << (g_programArgs.frameGenerations > 0 ? g_programArgs.frameGenerations :
+                      g_programArgs.generationLimit)
+                  << " generations" << (g_programArgs.pipeline ? ", pipelined" : "") << std::endl;
+
+    g_complexity = ei::ComplexityCost(g_programArgs.polygonCost, g_programArgs.vertexCost,
+                                      g_programArgs.areaBudget * g_width * g_height);
+
+    ei::Settings settings;
+    settings.setPolygonsMax(g_programArgs.polygonsMax);
+    settings.setPointsPerPolygonMax(g_programArgs.pointsMax);
+    settings.activate();
+
+    if (g_programArgs.guidedPercent > 0)
+    {
+        g_guidedSampler = new ei::GuidedSampler(g_programArgs.guidedPercent);
+        ei::Tools::setPositionSampler(g_guidedSampler);
+    }
+    if (g_programArgs.adaptEvery > 0)
+        g_adaptiveRates = new ei::AdaptiveRates(g_programArgs.adaptBound);
+    if (g_programArgs.acceptance == AcceptAnneal)
+        g_acceptance = new ei::AnnealingAcceptance(g_programArgs.acceptStart, g_programArgs.acceptEnd,
+                                                   g_programArgs.cooling);
+    else if (g_programArgs.acceptance == AcceptThreshold)
+        g_acceptance = new ei::ThresholdAcceptance(g_programArgs.acceptStart, g_programArgs.acceptEnd,
+                                                   g_programArgs.cooling);
+    else
+        g_acceptance = new ei::GreedyAcceptance();
+    if (g_programArgs.profile)
+    {
+        ei::AllocationCounter::enable();
+        g_profiler = new ei::PhaseProfiler();
+    }
+    if (g_programArgs.liveStatsFilename.length() &&
+        !g_liveStats.open(g_programArgs.liveStatsFilename.c_str()))
+        std::cout << "Cannot create live stats file " << g_programArgs.liveStatsFilename << std::endl;
+    publishLiveStats(ei::LiveStarting);
+    if (g_programArgs.traceFilename.length())
+    {
+        ei::TraceBuffer::start(g_programArgs.traceEvents);
+        ei::TraceBuffer::setThreadName("evolve");
+    }
+
+    if (g_programArgs.progressFilename.length())
+    {
+        g_progressFile = fopen(g_programArgs.progressFilename.c_str(), "w");
+        if (g_progressFile)
+            fprintf(g_progressFile, "seconds,generation,difference\n");
+        else
+            std::cout << "Cannot open progress file " << g_programArgs.progressFilename << std::endl;
+    }
+
+    if (g_programArgs.sequence)
+        runSequence();
+    else
+    {
+        if (!loadEnvironmentPng())
+            exit(0);
+        if (g_programArgs.splitColumns > 0)
+            runSplit(settings);
+        else
+            evolve(0);
+        generateLastDrawing();
+        saveDrawingJson(g_lastDrawing, g_programArgs.jsonFilename);
+    }
+    saveOpStats();
+    if (g_profiler)
+        reportProfile();
+    publishLiveStats(ei::LiveFinished);
+    logProgress(true);
+    if (g_progressFile)
+        fclose(g_progressFile);
+    if (ei::TraceBuffer::enabled())
+    {
+        if (ei::TraceBuffer::write(g_programArgs.traceFilename.c_str()))
+            std::cout << "Wrote trace to " << g_programArgs.traceFilename << std::endl;
+        else
+            std::cout << "Cannot write trace file " << g_programArgs.traceFilename << std::endl;
+    }
 
     delete g_lastDrawing;
+    ei::Tools::setPositionSampler(0);
+    delete g_guidedSampler;
+    delete g_adaptiveRates;
+    delete g_acceptance;
+    delete g_profiler;
+    cairo_surface_destroy(g_lastImage);
     cairo_surface_destroy(g_environmentImage);
 
     return 0;
@@ -0,0 +1,589 @@
+/*
+ *  evoquality - time-to-quality benchmark of whole evolver runs.
+ *  Part of evoimage-gl, a library and program to evolve images
+ *  Copyright (C) 2009-2022 Brent Burton
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include <cairo.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <limits.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <stdio.h>
+#include <stdlib.h>
+#include <cmath>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <memory>
+#include <json/json.h>
+
+#include "TargetImage.h"
+
+/*
+ * Runs evoimagecairo over a set of targets, configurations and seeds,
+ * reads back the --progress log of each run (difference against wall
+ * time), and reports how long each configuration took to bring the
+ * difference down to fixed thresholds. Thresholds are absolute (-Q),
+ * or fractions (-q) of the blank canvas difference: that of an
+ * all-black candidate, scored with the configuration's own -e mode and
+ * --ycc-weights. It does not depend on the first drawing, so runs of
+ * every configuration are measured against the same canvas.
+ */
+
+struct Config {
+    std::string name;
+    std::string args;                       // extra evoimagecairo switches
+    ei::DiffMode mode;                      // -e and --ycc-weights found in args
+    int lumaWeight;
+    int chromaWeight;
+};
+
+struct ProgramArgs {
+    std::string evolver;                    // evoimagecairo to run
+    std::string workDir;
+    std::string outFilename;
+    int generations;
+    bool synthetic;                         // add generated targets
+    std::vector<unsigned> seeds;
+    std::vector<double> thresholds;         // fractions of the blank difference...
+    bool absolute;                          // ...or, if set, differences
+    std::vector<Config> configs;
+    std::vector<std::string> targets;
+};
+ProgramArgs g_args;
+
+struct ProgressPoint {
+    double seconds;
+    int generation;
+    uint32_t difference;
+};
+
+struct RunResult {
+    std::string target;
+    std::string config;
+    unsigned seed;
+    double reference;                       // difference the thresholds are fractions of
+    std::vector<ProgressPoint> curve;
+    std::vector<double> thresholdSeconds;   // < 0 where never reached
+};
+
+void usage()
+{
+    std::cout << "usage: evoquality [options] target.png ...\n"
+              << "Switches:\n"
+              << "    -e path     evoimagecairo to run (default: next to evoquality)\n"
+              << "    -g n        Generations per run (default 20000)\n"
+              << "    -s seeds    Comma separated seeds (default 1,2,3)\n"
+              << "    -C name=args  Add a configuration: extra evoimagecairo switches,\n"
+              << "                e.g. -C 'c4=-c 4'. Repeatable. Default: c1, c2, c4\n"
+              << "    -q list     Comma separated fractions of the difference of a\n"
+              << "                blank (black) canvas to time, scored with each\n"
+              << "                configuration's -e mode (default 0.5,0.3,0.2,0.15)\n"
+              << "    -Q list     Comma separated absolute differences to time instead\n"
+              << "    -S          Also run generated synthetic targets\n"
+              << "    -w dir      Directory for runs and synthetic targets\n"
+              << "                (default evoquality-work)\n"
+              << "    -o file     Write all runs, with their curves, as JSON\n"
+              << std::endl;
+    exit(1);
+}
+
+/*
+ * A configuration, with the evaluation its switches select (the last
+ * -e and --ycc-weights win, as in evoimagecairo)
+ */
+static Config makeConfig(std::string const &name, std::string const &args)
+{
+    Config config = {name, args, ei::DiffRgb, 1, 1};
+    std::vector<std::string> words;
+    std::stringstream ss(args);
+    std::string word;
+    while (ss >> word)
+        words.push_back(word);
+
+    for (size_t i = 0; i < words.size(); i++)
+    {
+        std::string value;
+        if (words[i] == "-e" || words[i] == "--ycc-weights")
+            value = i + 1 < words.size() ? words[i + 1] : "";
+        else if (words[i].compare(0, 2, "-e") == 0)
+            value = words[i].substr(2);
+        else if (words[i].compare(0, 14, "--ycc-weights=") == 0)
+            value = words[i].substr(14);
+
+        if (words[i].compare(0, 2, "-e") == 0)
+            config.mode = value == "ycc" ? ei::DiffYcc : ei::DiffRgb;
+        else if (words[i].compare(0, 13, "--ycc-weights") == 0)
+            sscanf(value.c_str(), "%d,%d", &config.lumaWeight, &config.chromaWeight);
+    }
+    return config;
+}
+
+template <typename T>
+static bool parseList(const char *text, const char *format, std::vector<T> &list)
+{
+    list.clear();
+    std::stringstream ss(text);
+    std::string item;
+    while (std::getline(ss, item, ','))
+    {
+        T value;
+        if (1 != sscanf(item.c_str(), format, &value))
+            return false;
+        list.push_back(value);
+    }
+    return list.size() > 0;
+}
+
+void checkArgs(int argc, char *argv[])
+{
+    int option;
+
+    g_args.workDir = "evoquality-work";
+    g_args.generations = 20000;
+    g_args.synthetic = false;
+    g_args.absolute = false;
+    parseList("1,2,3", "%u", g_args.seeds);
+    parseList("0.5,0.3,0.2,0.15", "%lf", g_args.thresholds);
+
+    std::string self = argv[0];
+    size_t slash = self.rfind('/');
+    g_args.evolver = (slash == std::string::npos ? std::string(".") : self.substr(0, slash)) +
+                     "/evoimagecairo";
+
+    while (-1 != (option = getopt(argc, argv, "e:g:s:C:q:Q:Sw:o:")) )
+    {
+        switch (option)
+        {
+          case 'e':
+            g_args.evolver = optarg;
+            break;
+          case 'g':
+            if (1 != sscanf(optarg, "%d", &g_args.generations) || g_args.generations < 1)
+            {
+                std::cout << "invalid number for -g\n";
+                usage();
+            }
+            break;
+          case 's':
+            if (!parseList(optarg, "%u", g_args.seeds))
+            {
+                std::cout << "invalid seed list for -s\n";
+                usage();
+            }
+            break;
+          case 'C':
+          {
+            std::string text = optarg;
+            size_t eq = text.find('=');
+            if (eq == std::string::npos || eq == 0)
+            {
+                std::cout << "configurations are given as name=args\n";
+                usage();
+            }
+            g_args.configs.push_back(makeConfig(text.substr(0, eq), text.substr(eq + 1)));
+            break;
+          }
+          case 'q':
+            if (!parseList(optarg, "%lf", g_args.thresholds))
+            {
+                std::cout << "invalid fraction list for -q\n";
+                usage();
+            }
+            g_args.absolute = false;
+            break;
+          case 'Q':
+            if (!parseList(optarg, "%lf", g_args.thresholds))
+            {
+                std::cout << "invalid difference list for -Q\n";
+                usage();
+            }
+            g_args.absolute = true;
+            break;
+          case 'S':
+            g_args.synthetic = true;
+            break;
+          case 'w':
+            g_args.workDir = optarg;
+            break;
+          case 'o':
+            g_args.outFilename = optarg;
+            break;
+
+          case '?':
+          default:
+            usage();
+            break;
+        }
+    }
+
+    for (int i = optind; i < argc; i++)
+        g_args.targets.push_back(argv[i]);
+    if (g_args.targets.empty() && !g_args.synthetic)
+    {
+        std::cout << "No targets given.\n";
+        usage();
+    }
+    if (g_args.configs.empty())
+    {
+        g_args.configs.push_back(makeConfig("c1", "-c 1"));
+        g_args.configs.push_back(makeConfig("c2", "-c 2"));
+        g_args.configs.push_back(makeConfig("c4", "-c 4"));
+    }
+}
+
+/*
+ * Synthetic 200x200 targets with known character: a smooth gradient,
+ * and a few hard-edged shapes over a flat background.
+ */
+static void writeSyntheticTargets()
+{
+    cairo_surface_t *surface = cairo_image_surface_create(CAIRO_FORMAT_RGB24, 200, 200);
+    cairo_t *ctx = cairo_create(surface);
+
+    cairo_pattern_t *gradient = cairo_pattern_create_linear(0, 0, 200, 200);
+    cairo_pattern_add_color_stop_rgb(gradient, 0, 0.9, 0.2, 0.1);
+    cairo_pattern_add_color_stop_rgb(gradient, 1, 0.1, 0.3, 0.8);
+    cairo_set_source(ctx, gradient);
+    cairo_paint(ctx);
+    cairo_pattern_destroy(gradient);
+    std::string name = g_args.workDir + "/synthetic-gradient.png";
+    cairo_surface_write_to_png(surface, name.c_str());
+    g_args.targets.push_back(name);
+
+    cairo_set_source_rgb(ctx, 0.95, 0.9, 0.8);
+    cairo_paint(ctx);
+    cairo_set_source_rgb(ctx, 0.1, 0.4, 0.2);
+    cairo_rectangle(ctx, 20, 30, 70, 110);
+    cairo_fill(ctx);
+    cairo_set_source_rgb(ctx, 0.7, 0.1, 0.1);
+    cairo_arc(ctx, 140, 70, 40, 0, 2 * M_PI);
+    cairo_fill(ctx);
+    cairo_set_source_rgb(ctx, 0.1, 0.1, 0.5);
+    cairo_move_to(ctx, 100, 190);
+    cairo_line_to(ctx, 190, 120);
+    cairo_line_to(ctx, 180, 190);
+    cairo_close_path(ctx);
+    cairo_fill(ctx);
+    name = g_args.workDir + "/synthetic-shapes.png";
+    cairo_surface_write_to_png(surface, name.c_str());
+    g_args.targets.push_back(name);
+
+    cairo_destroy(ctx);
+    cairo_surface_destroy(surface);
+}
+
+static std::string baseName(std::string const &path)
+{
+    size_t slash = path.rfind('/');
+    return slash == std::string::npos ? path : path.substr(slash + 1);
+}
+
+/*
+ * Run the evolver in runDir, with stdout and stderr to run.log there.
+ * Returns true if it exited cleanly.
+ */
+static bool runEvolver(std::string const &runDir, std::vector<std::string> const &args)
+{
+    pid_t pid = fork();
+    if (pid < 0)
+        return false;
+    if (pid == 0)
+    {
+        if (0 != chdir(runDir.c_str()))
+            _exit(127);
+        int log = open("run.log", O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (log >= 0)
+        {
+            dup2(log, 1);
+            dup2(log, 2);
+            close(log);
+        }
+
+        std::vector<char *> argv;
+        for (auto &arg: args)
+            argv.push_back(const_cast<char *>(arg.c_str()));
+        argv.push_back(0);
+        execv(argv[0], argv.data());
+        _exit(127);
+    }
+
+    int status;
+    if (pid != waitpid(pid, &status, 0))
+        return false;
+    return WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+static bool readProgress(std::string const &filename, std::vector<ProgressPoint> &curve)
+{
+    std::ifstream ins(filename);
+    std::string line;
+    std::getline(ins, line);                // header
+    while (std::getline(ins, line))
+    {
+        ProgressPoint p;
+        if (3 == sscanf(line.c_str(), "%lf,%d,%u", &p.seconds, &p.generation, &p.difference))
+            curve.push_back(p);
+    }
+    return curve.size() > 0;
+}
+
+/*
+ * The difference of an all-black candidate from the target (its top
+ * left 200x200), measured as evoimagecairo does under config. Negative
+ * if the target cannot be read.
+ */
+static double blankDifference(std::string const &target, Config const &config)
+{
+    const int size = 200;
+    cairo_surface_t *surface = cairo_image_surface_create_from_png(target.c_str());
+    if (cairo_surface_status(surface) != CAIRO_STATUS_SUCCESS ||
+        cairo_image_surface_get_width(surface) < size ||
+        cairo_image_surface_get_height(surface) < size)
+    {
+        cairo_surface_destroy(surface);
+        return -1;
+    }
+
+    ei::TargetImage image;
+    int stride = cairo_image_surface_get_stride(surface);
+    bool loaded = image.load(cairo_image_surface_get_data(surface), size, size, stride);
+    cairo_surface_destroy(surface);
+    if (!loaded)
+        return -1;
+
+    image.setYccWeights(config.lumaWeight, config.chromaWeight);
+    std::vector<uint8_t> black(size * size * 4, 0);
+    return image.difference(config.mode, black.data(), size * 4, 0, 0, size, size);
+}
+
+static bool runOne(std::string const &target, Config const &config, unsigned seed,
+                   double reference, RunResult &result)
+{
+    char runName[64];
+    snprintf(runName, sizeof(runName), "-s%u", seed);
+    std::string runDir = g_args.workDir + "/" + baseName(target) + "-" + config.name + runName;
+    mkdir(runDir.c_str(), 0777);
+    mkdir((runDir + "/mutations").c_str(), 0777);
+
+    char resolved[PATH_MAX];
+    std::vector<std::string> args;
+    args.push_back(realpath(g_args.evolver.c_str(), resolved) ? resolved : g_args.evolver);
+    std::stringstream ss(config.args);
+    std::string arg;
+    while (ss >> arg)
+        args.push_back(arg);
+    args.push_back("-s");
+    args.push_back(std::to_string(seed));
+    args.push_back("-g");
+    args.push_back(std::to_string(g_args.generations));
+    args.push_back("--progress");
+    args.push_back("progress.csv");
+    args.push_back(realpath(target.c_str(), resolved) ? resolved : target);
+
+    result.target = baseName(target);
+    result.config = config.name;
+    result.seed = seed;
+    result.reference = reference;
+    if (!runEvolver(runDir, args) || !readProgress(runDir + "/progress.csv", result.curve))
+    {
+        std::cout << "    run failed, see " << runDir << "/run.log" << std::endl;
+        return false;
+    }
+
+    for (double threshold: g_args.thresholds)
+    {
+        double seconds = -1;
+        for (auto &p: result.curve)
+        {
+            if (p.difference <= threshold * reference)
+            {
+                seconds = p.seconds;
+                break;
+            }
+        }
+        result.thresholdSeconds.push_back(seconds);
+    }
+    return true;
+}
+
+/*
+ * Median over the seeds, with unreached thresholds (negative) counted
+ * as slower than any reached one. Returns negative if the median run
+ * never got there.
+ */
+static double median(std::vector<double> values)
+{
+    for (auto &v: values)
+        if (v < 0)
+            v = INFINITY;
+    std::sort(values.begin(), values.end());
+    double m = values[values.size() / 2];
+    return std::isinf(m) ? -1 : m;
+}
+
+static void printSummary(std::vector<RunResult> const &runs)
+{
+    for (auto &target: g_args.targets)
+    {
+        std::cout << '\n' << baseName(target) << " (median of " << g_args.seeds.size()
+                  << " seeds; seconds to reach ";
+        if (g_args.absolute)
+            std::cout << "each difference)\n";
+        else
+            std::cout << "a fraction of the blank canvas difference)\n";
+        char line[256];
+        int n = snprintf(line, sizeof(line), "    %-12s %12s %9s %9s", "config", "final diff",
+                         "seconds", "gens/s");
+        if (!g_args.absolute)
+            n += snprintf(line + n, sizeof(line) - n, " %12s", "blank diff");
+        for (double threshold: g_args.thresholds)
+        {
+            if (g_args.absolute)
+                n += snprintf(line + n, sizeof(line) - n, " %9.0f", threshold);
+            else
+                n += snprintf(line + n, sizeof(line) - n, " %8.0f%%", threshold * 100);
+        }
+        std::cout << line << std::endl;
+
+        for (auto &config: g_args.configs)
+        {
+            std::vector<double> finals, seconds, rates;
+            std::vector<std::vector<double> > reached(g_args.thresholds.size());
+            double reference = 0;
+            for (auto &run: runs)
+            {
+                if (run.target != baseName(target) || run.config != config.name)
+                    continue;
+                ProgressPoint const &last = run.curve.back();
+                finals.push_back(last.difference);
+                seconds.push_back(last.seconds);
+                rates.push_back(last.generation / std::max(last.seconds, 1e-9));
+                reference = run.reference;
+                for (size_t t = 0; t < reached.size(); t++)
+                    reached[t].push_back(run.thresholdSeconds[t]);
+            }
+            if (finals.empty())
+                continue;
+
+            n = snprintf(line, sizeof(line), "    %-12s %12.0f %9.2f %9.0f", config.name.c_str(),
+                         median(finals), median(seconds), median(rates));
+            if (!g_args.absolute)
+                n += snprintf(line + n, sizeof(line) - n, " %12.0f", reference);
+            for (auto &r: reached)
+            {
+                double m = median(r);
+                if (m < 0)
+                    n += snprintf(line + n, sizeof(line) - n, " %9s", "-");
+                else
+                    n += snprintf(line + n, sizeof(line) - n, " %9.2f", m);
+            }
+            std::cout << line << std::endl;
+        }
+    }
+}
+
+static void saveResults(std::vector<RunResult> const &runs)
+{
+    Json::Value results;
+    results["generations"] = g_args.generations;
+    results["absolute"] = g_args.absolute;
+    for (double threshold: g_args.thresholds)
+        results["thresholds"].append(threshold);
+    for (auto &config: g_args.configs)
+        results["configs"][config.name] = config.args;
+
+    Json::Value runList(Json::arrayValue);
+    for (auto &run: runs)
+    {
+        Json::Value r;
+        r["target"] = run.target;
+        r["config"] = run.config;
+        r["seed"] = run.seed;
+        r["reference"] = run.reference;
+        for (double seconds: run.thresholdSeconds)
+            r["threshold_seconds"].append(seconds < 0 ? Json::Value() : Json::Value(seconds));
+
+        Json::Value curve(Json::arrayValue);
+        for (auto &p: run.curve)
+        {
+            Json::Value point(Json::arrayValue);
+            point.append(p.seconds);
+            point.append(p.generation);
+            point.append(p.difference);
+            curve.append(point);
+        }
+        r["curve"] = curve;
+        runList.append(r);
+    }
+    results["runs"] = runList;
+
+    std::ofstream outfile(g_args.outFilename);
+    Json::StreamWriterBuilder builder;
+    builder["indentation"] = "    ";
+    std::unique_ptr<Json::StreamWriter> writer( builder.newStreamWriter() );
+    writer->write(results, &outfile);
+    std::cout << "Wrote results to " << g_args.outFilename << std::endl;
+}
+
+int main(int argc, char **argv)
+{
+    checkArgs(argc, argv);
+
+    if (0 != mkdir(g_args.workDir.c_str(), 0777) && errno != EEXIST)
+    {
+        std::cout << "Cannot create " << g_args.workDir << std::endl;
+        return 1;
+    }
+    if (g_args.synthetic)
+        writeSyntheticTargets();
+
+    std::vector<RunResult> runs;
+    for (auto &target: g_args.targets)
+    {
+        for (auto &config: g_args.configs)
+        {
+            double reference = g_args.absolute ? 1 : blankDifference(target, config);
+            if (reference < 0)
+            {
+                std::cout << "Cannot read " << target << ", skipping it" << std::endl;
+                break;
+            }
+            for (unsigned seed: g_args.seeds)
+            {
+                std::cout << baseName(target) << ' ' << config.name << " seed " << seed
+                          << std::endl;
+                RunResult result;
+                if (runOne(target, config, seed, reference, result))
+                    runs.push_back(result);
+            }
+        }
+    }
+
+    printSummary(runs);
+    if (g_args.outFilename.length())
+        saveResults(runs);
+
+    return 0;
+}
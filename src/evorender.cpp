@@ -29,23 +29,32 @@
 #include <string>
 #include <json/json.h>
 #include <memory>
+#include <vector>
+#include <algorithm>
 
 struct ProgramArgs {
     std::string inFilename;
     std::string outFilename;
     uint32_t width;                         // final rendered resolution
     uint32_t height;
+    uint32_t maxPolygons;                   // render at most this many; 0 = all
+    double areaBudget;                      // most filled area, in canvases; 0 = any
 };
-ProgramArgs g_args {"", "", 200, 200};
+ProgramArgs g_args {"", "", 200, 200, 0, 0};
 
 void usage()
 {
-    std::cout << "usage: evorender -i input.json -o output.png [-w 200] [-h 200]\n"
+    std::cout << "usage: evorender -i input.json -o output.png [-w 200] [-h 200] [-n count] [-a f]\n"
               << "Switches:\n"
               << "    -i input.json  Input JSON, created by evoimagecairo\n"
               << "    -o output.png  Output PNG file.\n"
               << "    -w width       Output resolution width. Default is 200.\n"
               << "    -h height      Output resolution height. Default is 200.\n"
+              << "    -n count       Render at most count polygons.\n"
+              << "    -a f           Fill at most f times the canvas, overdraw included.\n"
+              << "                   Both drop the polygons that add least first\n"
+              << "                   (area times opacity), like evoimagecairo's\n"
+              << "                   --area-budget keeps render cost bounded.\n"
               << std::endl;
     exit(1);
 }
@@ -54,7 +63,7 @@ void checkArgs(int argc, char *argv[])
 {
     int option;
     int temp;
-    while (-1 != (option = getopt(argc, argv, "i:o:w:h:")) )
+    while (-1 != (option = getopt(argc, argv, "i:o:w:h:n:a:")) )
     {
         switch (option)
         {
@@ -80,6 +89,21 @@ void checkArgs(int argc, char *argv[])
             }
             g_args.height = temp;
             break;
+          case 'n':
+            if (1 != sscanf(optarg, "%d", &temp) || temp < 1)
+            {
+                std::cout << "invalid number for -n\n";
+                usage();
+            }
+            g_args.maxPolygons = temp;
+            break;
+          case 'a':
+            if (1 != sscanf(optarg, "%lf", &g_args.areaBudget) || g_args.areaBudget <= 0)
+            {
+                std::cout << "invalid number for -a\n";
+                usage();
+            }
+            break;
 
           case '?':
           default:
@@ -102,6 +126,77 @@ void checkArgs(int argc, char *argv[])
     }
 }
 
+/*
+ * Area of a polygon in canvases: coordinates run from 0 to 1
+ */
+double polygonArea(Json::Value &polygon)
+{
+    Json::Value &points = polygon["points"];
+    if (!points.isArray())
+        throw std::logic_error("JSON 'points' is not an array");
+
+    double twice = 0;
+    for (uint32_t i = 0, n = points.size(); i < n; ++i)
+    {
+        Json::Value &a = points[i], &b = points[(i + 1) % n];
+        twice += a["x"].asDouble() * b["y"].asDouble() - b["x"].asDouble() * a["y"].asDouble();
+    }
+    return std::fabs(twice / 2);
+}
+
+/*
+ * Report what the drawing costs to render, and drop the polygons that
+ * add least (area times opacity) until it is within -n and -a.
+ */
+void applyBudget(Json::Value &drawing)
+{
+    Json::Value &polygons = drawing["polygons"];
+    if (!polygons.isArray())
+        throw std::logic_error("JSON 'polygons' is not an array");
+
+    uint32_t count = polygons.size(), vertices = 0;
+    std::vector<double> area(count);
+    double totalArea = 0;
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        area[i] = polygonArea(polygons[i]);
+        totalArea += area[i];
+        vertices += polygons[i]["points"].size();
+    }
+    std::cout << count << " polygons, " << vertices << " vertices, filling "
+              << totalArea << " canvases" << std::endl;
+
+    std::vector<uint32_t> order(count);
+    for (uint32_t i = 0; i < count; ++i)
+        order[i] = i;
+    std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b)
+                     { return area[a] * polygons[a]["color"]["a"].asDouble() <
+                              area[b] * polygons[b]["color"]["a"].asDouble(); });
+
+    std::vector<bool> dropped(count, false);
+    uint32_t kept = count;
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        bool overCount = g_args.maxPolygons > 0 && kept > g_args.maxPolygons;
+        bool overArea = g_args.areaBudget > 0 && totalArea > g_args.areaBudget;
+        if (!overCount && !overArea)
+            break;
+        dropped[order[i]] = true;
+        totalArea -= area[order[i]];
+        kept--;
+    }
+    if (kept == count)
+        return;
+
+    Json::Value remaining(Json::arrayValue);
+    for (uint32_t i = 0; i < count; ++i)
+        if (!dropped[i])
+            remaining.append(polygons[i]);
+    polygons = remaining;
+    std::cout << "Dropped " << count - kept << " polygons to fit the budget, leaving "
+              << kept << " filling " << totalArea << " canvases" << std::endl;
+}
+
 void renderDrawing(Json::Value &drawing)
 {
     cairo_surface_t *surface = 0;
@@ -172,6 +267,7 @@ void loadAndRenderDrawing()
     ins >> drawing;
     ins.close();
 
+    applyBudget(drawing);
     renderDrawing(drawing);
 }
 
@@ -0,0 +1,101 @@
+/*
+ *  evostat - print the live progress of an evoimagecairo run.
+ *  Part of evoimage-gl, a library and program to evolve images
+ *  Copyright (C) 2009-2022 Brent Burton
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include <unistd.h>
+#include <iostream>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "LiveStats.h"
+
+static const char *stateNames[] = {"starting", "running", "finished"};
+
+void usage()
+{
+    std::cout << "usage: evostat [-w seconds] file.stats\n"
+              << "Print the progress of a run started with evoimagecairo --live-stats.\n"
+              << "Switches:\n"
+              << "    -w seconds  Keep printing every 'seconds' until the run finishes.\n"
+              << std::endl;
+    exit(1);
+}
+
+static bool printStats(const char *filename)
+{
+    ei::LiveStatsData data;
+    uint32_t pid;
+    if (!ei::LiveStats::read(filename, data, pid))
+    {
+        std::cout << "Cannot read live stats from " << filename << std::endl;
+        return false;
+    }
+
+    time_t updated = data.updated / 1000;
+    char when[32];
+    strftime(when, sizeof(when), "%H:%M:%S", localtime(&updated));
+
+    std::cout << "pid " << pid << ' '
+              << (data.state < 3 ? stateNames[data.state] : "unknown")
+              << " at " << when << ": generation " << data.generation
+              << '/' << data.generationLimit
+              << ", difference " << data.difference
+              << " (last improved at " << data.lastImprovement << "), "
+              << data.polygons << " polys, " << data.points << " points, "
+              << (int)data.gensPerSecond << " gens/s" << std::endl;
+
+    uint64_t phaseNs = 0;
+    for (int i = 0; i < ei::PhaseCount; i++)
+        phaseNs += data.phaseNs[i];
+    if (phaseNs)
+    {
+        std::cout << "   ";
+        for (int i = 0; i < ei::PhaseCount; i++)
+            std::cout << ' ' << ei::profilePhaseName(ei::ProfilePhase(i)) << ' '
+                      << data.phaseNs[i] / 1e9 << 's';
+        std::cout << std::endl;
+    }
+    return data.state != ei::LiveFinished;
+}
+
+int main(int argc, char **argv)
+{
+    int option;
+    int wait = 0;
+    while (-1 != (option = getopt(argc, argv, "w:")) )
+    {
+        switch (option)
+        {
+          case 'w':
+            if (1 != sscanf(optarg, "%d", &wait) || wait < 1)
+                usage();
+            break;
+          default:
+            usage();
+        }
+    }
+    if (optind + 1 != argc)
+        usage();
+
+    while (printStats(argv[optind]) && wait > 0)
+        sleep(wait);
+
+    return 0;
+}
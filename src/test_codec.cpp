@@ -0,0 +1,133 @@
+/*
+ *  Evoimage-gl, a library and program to evolve images
+ *  Copyright (C) 2009 Brent Burton
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+#include <iostream>
+#include <vector>
+#include <stdlib.h>
+#include "Settings.h"
+#include "Tools.h"
+#include "DnaDrawing.h"
+#include "DnaCodec.h"
+
+/*
+ * Checks the invariants of DnaCodec: drawings survive a round trip
+ * exactly, and decode() rejects anything encode() could not have made.
+ * Exits non-zero if any check fails.
+ */
+
+static int g_failures = 0;
+
+static void check(bool ok, const char *what)
+{
+    if (!ok)
+    {
+        std::cout << "FAILED: " << what << std::endl;
+        g_failures++;
+    }
+}
+
+static bool sameDrawing(ei::DnaDrawing &a, ei::DnaDrawing &b)
+{
+    ei::DnaPolygonList &pa = a.polygons(), &pb = b.polygons();
+    if (pa.size() != pb.size())
+        return false;
+    for (size_t i = 0; i < pa.size(); i++)
+    {
+        ei::DnaBrush &ba = pa[i].brush(), &bb = pb[i].brush();
+        if (ba.r != bb.r || ba.g != bb.g || ba.b != bb.b || ba.a != bb.a)
+            return false;
+        ei::DnaPointList &qa = pa[i].points(), &qb = pb[i].points();
+        if (qa.size() != qb.size())
+            return false;
+        for (size_t j = 0; j < qa.size(); j++)
+            if (qa[j].x != qb[j].x || qa[j].y != qb[j].y)
+                return false;
+    }
+    return true;
+}
+
+// Whether decode() rejects these bytes
+static bool rejects(std::vector<uint8_t> const &bytes)
+{
+    ei::DnaDrawing *d = ei::DnaCodec::decode(bytes.data(), bytes.size());
+    delete d;
+    return d == 0;
+}
+
+int main(int argc, char *argv[])
+{
+    srand(1);
+    ei::Settings settings;
+    settings.activate();
+
+    ei::DnaDrawing *drawing = new ei::DnaDrawing();
+    drawing->init();
+    for (int i = 0; i < 20000; i++)
+        drawing->mutate();
+
+    // The corners of the canvas are the extremes of the coordinate range
+    ei::DnaPointList &corners = drawing->polygons()[0].points();
+    corners[0] = ei::DnaPoint(0, 0);
+    corners[1] = ei::DnaPoint(ei::Tools::maxWidth, ei::Tools::maxHeight);
+
+    size_t size = ei::DnaCodec::encodedSize(*drawing);
+    std::vector<uint8_t> bytes(size);
+    check(size <= ei::DnaCodec::maxSize(drawing->polygons().size(),
+                                        ei::Settings::activePointsPerPolygonMax),
+          "encodedSize within maxSize");
+    check(ei::DnaCodec::encode(*drawing, bytes.data(), size) == size, "encode fills encodedSize");
+    check(ei::DnaCodec::encode(*drawing, bytes.data(), size - 1) == 0, "encode respects capacity");
+
+    ei::DnaDrawing *decoded = ei::DnaCodec::decode(bytes.data(), bytes.size());
+    check(decoded && sameDrawing(*drawing, *decoded), "round trip");
+    delete decoded;
+
+    // Every truncation, and trailing bytes, are malformed
+    bool truncations = true;
+    for (size_t n = 0; n < size; n++)
+        truncations = truncations && rejects(std::vector<uint8_t>(bytes.begin(), bytes.begin() + n));
+    check(truncations, "decode rejects truncated buffers");
+    std::vector<uint8_t> longer(bytes);
+    longer.push_back(0);
+    check(rejects(longer), "decode rejects trailing bytes");
+
+    // A count claiming more polygons than the bytes can hold
+    std::vector<uint8_t> bigCount(bytes);
+    bigCount[0] = bigCount[1] = 0xff;
+    check(rejects(bigCount), "decode rejects an oversized polygon count");
+
+    // One polygon: point count, r, g, b, a, then x, y pairs
+    std::vector<uint8_t> two = {1, 0, 2, 10, 20, 30, 40, 1, 0, 2, 0, 3, 0, 4, 0};
+    check(rejects(two), "decode rejects a two point polygon");
+    std::vector<uint8_t> triangle = {1, 0, 3, 10, 20, 30, 40, 1, 0, 2, 0, 3, 0, 4, 0, 5, 0, 6, 0};
+    decoded = ei::DnaCodec::decode(triangle.data(), triangle.size());
+    check(decoded && decoded->polygons().size() == 1 &&
+          decoded->polygons()[0].points()[2].y == 6, "decode accepts a triangle");
+    delete decoded;
+    std::vector<uint8_t> outside(triangle);
+    outside[7] = ei::Tools::maxWidth + 1;
+    check(rejects(outside), "decode rejects a coordinate off the canvas");
+
+    // Coordinates that do not fit in u16 are not encoded
+    corners[0] = ei::DnaPoint(-1, 0);
+    check(ei::DnaCodec::encode(*drawing, bytes.data(), size) == 0, "encode rejects negative coordinates");
+
+    delete drawing;
+    std::cout << (g_failures ? "test_codec: FAILED" : "test_codec: ok") << std::endl;
+    return g_failures ? 1 : 0;
+}
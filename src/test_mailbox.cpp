@@ -0,0 +1,166 @@
+/*
+ *  Evoimage-gl, a library and program to evolve images
+ *  Copyright (C) 2009 Brent Burton
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+#include <iostream>
+#include <vector>
+#include <atomic>
+#include <pthread.h>
+#include <sched.h>
+#include <stdlib.h>
+#include "Settings.h"
+#include "DnaDrawing.h"
+#include "DnaCodec.h"
+#include "IslandMailbox.h"
+
+/*
+ * Checks IslandMailbox: a posted drawing is taken back exactly and only
+ * once per posting, an oversized one is refused, and readers never
+ * return a drawing that was being rewritten as they read it. Exits
+ * non-zero if any check fails.
+ */
+
+static int g_failures = 0;
+
+static void check(bool ok, const char *what)
+{
+    if (!ok)
+    {
+        std::cout << "FAILED: " << what << std::endl;
+        g_failures++;
+    }
+}
+
+static std::vector<uint8_t> encoded(ei::DnaDrawing &d)
+{
+    std::vector<uint8_t> bytes(ei::DnaCodec::encodedSize(d));
+    ei::DnaCodec::encode(d, bytes.data(), bytes.size());
+    return bytes;
+}
+
+static ei::DnaDrawing *randomDrawing(int mutations)
+{
+    ei::DnaDrawing *d = new ei::DnaDrawing();
+    d->init();
+    for (int i = 0; i < mutations; i++)
+        d->mutate();
+    return d;
+}
+
+struct Writer
+{
+    ei::IslandMailbox *mailbox;
+    ei::DnaDrawing *drawings[2];
+    std::atomic<bool> stop;
+};
+
+static void *writeAlternately(void *arg)
+{
+    Writer *w = static_cast<Writer *>(arg);
+    for (int i = 0; !w->stop.load(); i++)
+    {
+        w->mailbox->post(1, *w->drawings[i & 1]);
+
+        // Pause for varying times, so reads both overlap posts and fit
+        // between them
+        for (volatile int spin = 0; spin < (i % 8) * 1000; spin++)
+            ;
+        sched_yield();
+    }
+    return 0;
+}
+
+int main(int argc, char *argv[])
+{
+    srand(1);
+    ei::Settings settings;
+    settings.activate();
+
+    const int polygons = ei::Settings::activePolygonsMax;
+    ei::IslandMailbox mailbox;
+    check(mailbox.create(2, polygons, ei::Settings::activePointsPerPolygonMax), "create");
+
+    ei::DnaDrawing *drawing = randomDrawing(20000);
+    uint32_t serial = 0;
+    check(mailbox.take(0, serial) == 0, "nothing to take before a post");
+    check(mailbox.post(0, *drawing), "post");
+    ei::DnaDrawing *taken = mailbox.take(0, serial);
+    check(taken && encoded(*taken) == encoded(*drawing), "take returns the posted drawing");
+    check(serial == 1, "take updates the serial");
+    delete taken;
+    check(mailbox.take(0, serial) == 0, "a posting is taken once");
+
+    // A reader that finds the slot mid-write gets nothing, and may retry
+    check(mailbox.post(0, *drawing), "post again");
+    mailbox.slot(0).sequence.fetch_add(1);
+    check(mailbox.take(0, serial) == 0 && serial == 1, "take skips a slot being written");
+    mailbox.slot(0).sequence.fetch_add(1);
+    taken = mailbox.take(0, serial);
+    check(taken && serial == 2, "take succeeds once the write is done");
+    delete taken;
+
+    // More than the mailbox was sized for
+    ei::DnaDrawing *tooBig = drawing->clone();
+    ei::DnaPolygonList list = tooBig->polygons();
+    size_t capacity = ei::DnaCodec::maxSize(polygons, ei::Settings::activePointsPerPolygonMax);
+    while (ei::DnaCodec::encodedSize(*tooBig) <= capacity)
+    {
+        list.push_back(list[0]);
+        tooBig->setPolygons(list);
+    }
+    check(!mailbox.post(0, *tooBig), "post refuses a drawing over capacity");
+    check(mailbox.slot(0).posted.load() == 2, "a refused post is not counted");
+    delete tooBig;
+
+    // Race a writer flipping between two drawings: every take must be
+    // exactly one of them
+    Writer writer;
+    writer.mailbox = &mailbox;
+    writer.drawings[0] = drawing;
+    writer.drawings[1] = randomDrawing(40000);
+    writer.stop.store(false);
+    std::vector<uint8_t> a = encoded(*writer.drawings[0]), b = encoded(*writer.drawings[1]);
+
+    pthread_t thread;
+    pthread_create(&thread, NULL, writeAlternately, &writer);
+    int takes = 0, torn = 0;
+    uint32_t raceSerial = 0;
+    for (int tries = 0; takes < 2000 && tries < 10000000; tries++)
+    {
+        ei::DnaDrawing *d = mailbox.take(1, raceSerial);
+        if (!d)
+        {
+            sched_yield();
+            continue;
+        }
+        std::vector<uint8_t> bytes = encoded(*d);
+        if (bytes != a && bytes != b)
+            torn++;
+        takes++;
+        delete d;
+    }
+    writer.stop.store(true);
+    pthread_join(thread, NULL);
+    check(takes > 0, "takes while racing a writer");
+    check(torn == 0, "no torn drawing is returned");
+    std::cout << takes << " takes while racing the writer" << std::endl;
+
+    delete writer.drawings[1];
+    delete drawing;
+    std::cout << (g_failures ? "test_mailbox: FAILED" : "test_mailbox: ok") << std::endl;
+    return g_failures ? 1 : 0;
+}